@@ -0,0 +1,109 @@
+#include "file_descriptor.hh"
+#include "packet_buffer.hh"
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <fcntl.h>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Number of calls to the global operator new so far
+static size_t allocations = 0;
+
+void *operator new(const size_t size) {
+    allocations++;
+    if (void *ret = malloc(size == 0 ? 1 : size)) {
+        return ret;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept { free(ptr); }
+
+void operator delete(void *ptr, const size_t /* size */) noexcept { free(ptr); }
+
+//! Allocations made by each stage of the transfer
+struct Counts {
+    size_t sender{};    //!< Writing to the sender's stream, filling the window and taking ACKs
+    size_t write{};     //!< Serializing each segment and writing it to a file descriptor
+    size_t wire{};      //!< Serializing each segment into a packet and parsing it back
+    size_t receiver{};  //!< Receiving each segment and reading the stream
+};
+
+//! Measure the allocations made by one stage
+template <typename Stage>
+static void count(size_t &counter, Stage &&stage) {
+    const size_t before = allocations;
+    stage();
+    counter += allocations - before;
+}
+
+//! Move `total` bytes from a sender to a receiver, written by the application `write_size` bytes at a time
+static void transfer(const size_t total, const size_t write_size) {
+    TCPConfig config;
+    config.send_capacity = config.recv_capacity = 256 * 1024;
+    TCPSender sender{config};
+    TCPReceiver receiver{config};
+    const string chunk(write_size, 'x');
+    FileDescriptor devnull{SystemCall("open", open("/dev/null", O_WRONLY))};
+    string packet;
+    Counts counts;
+    size_t segments = 0, delivered = 0;
+
+    size_t written = 0;
+    while (delivered < total) {
+        count(counts.sender, [&] {
+            while (written < total and sender.stream_in().remaining_capacity() >= write_size) {
+                written += sender.stream_in().write(chunk);
+            }
+            sender.fill_window();
+        });
+
+        while (not sender.segments_out().empty()) {
+            count(counts.write, [&] { devnull.write(sender.segments_out().front().serialize()); });
+            TCPSegment received;
+            count(counts.wire, [&] {
+                packet.clear();
+                sender.segments_out().front().serialize_into(packet);
+                sender.segments_out().pop();
+                if (received.parse(Buffer(PacketBuffer(packet))) != ParseResult::NoError) {
+                    throw runtime_error("parse error");
+                }
+            });
+            count(counts.receiver, [&] {
+                receiver.segment_received(received);
+                delivered += receiver.stream_out().read_buffer(receiver.stream_out().buffer_size()).size();
+            });
+            segments++;
+        }
+
+        count(counts.sender, [&] { sender.ack_received(receiver.ackno().value(), receiver.window_size()); });
+    }
+
+    const auto per_segment = [&](const size_t n) { return 1.0 * n / segments; };
+    cout << "  " << setw(5) << write_size << "-byte writes, " << segments << " segments: " << fixed
+         << setprecision(2) << "sender " << setw(5) << per_segment(counts.sender) << ", write " << setw(4)
+         << per_segment(counts.write) << ", wire " << setw(4) << per_segment(counts.wire) << ", receiver "
+         << setw(4) << per_segment(counts.receiver) << " allocations/segment\n";
+}
+
+int main() {
+    try {
+        cout << "Heap allocations in the sender and receiver paths\n";
+        for (const size_t write_size : {100u, 1452u, 16384u}) {
+            transfer(16 * 1024 * 1024, write_size);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+#include "byte_stream.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+using namespace std;
+
+//! The string-backed ByteStream that the ring buffer replaced, kept here for comparison
+class StringByteStream {
+    string _buffer{};
+    size_t _capacity;
+
+  public:
+    explicit StringByteStream(const size_t capacity) : _capacity(capacity) {}
+
+    size_t write(const string &data) {
+        const size_t writebytes = min(_capacity - _buffer.size(), data.size());
+        _buffer.append(data.substr(0, writebytes));
+        return writebytes;
+    }
+
+    string read(const size_t len) {
+        string ret = _buffer.substr(0, len);
+        _buffer.erase(0, len);
+        return ret;
+    }
+
+    size_t buffer_size() const { return _buffer.size(); }
+};
+
+static constexpr size_t CAPACITY = 65536;
+static constexpr size_t WRITE_SIZE = 1452;
+static constexpr size_t TOTAL_BYTES = size_t(1) << 23;
+
+//! Fill the stream to capacity with segment-sized writes, then drain it with `read_size`-byte reads
+template <typename Stream, typename ReadFunc>
+void benchmark(const string &name, const size_t read_size, ReadFunc &&read) {
+    Stream stream{CAPACITY};
+    const string chunk(WRITE_SIZE, 'x');
+    size_t bytes_moved = 0;
+
+    const auto start = chrono::steady_clock::now();
+    while (bytes_moved < TOTAL_BYTES) {
+        while (stream.write(chunk) == WRITE_SIZE) {
+        }
+        while (stream.buffer_size() > 0) {
+            bytes_moved += read(stream, read_size);
+        }
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double seconds = chrono::duration<double>(duration).count();
+    const double gigabits = 8.0 * bytes_moved / 1e9;
+    cout << "  " << left << setw(18) << name << right << setw(6) << read_size << "-byte reads: " << fixed
+         << setprecision(2) << gigabits / seconds << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        cout << "ByteStream throughput (capacity " << CAPACITY << ", " << WRITE_SIZE << "-byte writes)\n";
+        for (const size_t read_size : {16u, 256u, 1452u, 16384u}) {
+            benchmark<StringByteStream>(
+                "std::string", read_size, [](StringByteStream &s, const size_t len) { return s.read(len).size(); });
+            benchmark<ByteStream>(
+                "ring read()", read_size, [](ByteStream &s, const size_t len) { return s.read(len).size(); });
+            benchmark<ByteStream>("ring read_view()", read_size, [](ByteStream &s, const size_t len) {
+                const auto [first, second] = s.read_view(len);
+                return first.size() + second.size();
+            });
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
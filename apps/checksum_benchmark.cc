@@ -0,0 +1,175 @@
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! The byte-at-a-time InternetChecksum that the word-at-a-time kernels replaced, kept here for comparison
+class ByteChecksum {
+    uint32_t _sum{};
+    bool _parity{};
+
+  public:
+    void add(const string_view data) {
+        for (const char c : data) {
+            uint16_t val = uint8_t(c);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint32_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+static constexpr size_t TOTAL_BYTES = size_t{1} << 28;
+
+//! Checksum `payload` over and over, TOTAL_BYTES in all, and report the throughput
+//! \returns the checksum of `payload`
+template <typename MakeChecksum>
+uint16_t benchmark(const string &name, const string_view payload, MakeChecksum &&make_checksum) {
+    const size_t iterations = TOTAL_BYTES / payload.size();
+    uint16_t result = 0;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        auto checksum = make_checksum();
+        checksum.add(payload);
+        result |= checksum.value();
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double seconds = chrono::duration<double>(duration).count();
+    const double gigabytes = 1.0 * iterations * payload.size() / 1e9;
+    cout << "  " << left << setw(7) << name << right << setw(6) << payload.size() << "-byte payloads: " << fixed
+         << setprecision(2) << setw(6) << gigabytes / seconds << " GB/s\n";
+    return result;
+}
+
+//! Serialize segments carrying `payload` into one contiguous packet each, TOTAL_BYTES of payload in all,
+//! and report the throughput
+//! \returns the last packet
+template <typename Serialize>
+string benchmark_serialize(const string &name, const Buffer &payload, Serialize &&serialize) {
+    const size_t iterations = TOTAL_BYTES / payload.size();
+    string packet;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        // a new segment every time, so that nothing is cached
+        TCPSegment seg;
+        seg.header().seqno = WrappingInt32(i);
+        seg.set_payload(payload);
+        serialize(seg, packet);
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double seconds = chrono::duration<double>(duration).count();
+    const double gigabytes = 1.0 * iterations * payload.size() / 1e9;
+    cout << "  " << left << setw(14) << name << right << setw(6) << payload.size() << "-byte payloads: " << fixed
+         << setprecision(2) << setw(6) << gigabytes / seconds << " GB/s\n";
+    return packet;
+}
+
+//! Serialize a header with a timestamps option over and over, and report the time per header
+//! \returns a byte of the last header, so the work can't be skipped
+template <typename Serialize>
+uint8_t benchmark_header(const string &name, Serialize &&serialize) {
+    constexpr size_t iterations = 1 << 24;
+    TCPHeader header;
+    header.ack = true;
+    header.timestamps = TCPTimestamps{1, 2};
+    header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+    uint8_t result = 0;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        header.seqno = WrappingInt32(i);
+        result ^= serialize(header);
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double nanoseconds = chrono::duration<double, nano>(duration).count();
+    cout << "  " << left << setw(14) << name << right << fixed << setprecision(1) << setw(6)
+         << nanoseconds / iterations << " ns/header\n";
+    return result;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+        string data(65536, 0);
+        for (auto &c : data) {
+            c = static_cast<char>(rd());
+        }
+
+        const vector<pair<InternetChecksum::Kernel, string>> kernels{{InternetChecksum::Kernel::Scalar, "scalar"},
+                                                                     {InternetChecksum::Kernel::SSE2, "SSE2"},
+                                                                     {InternetChecksum::Kernel::AVX2, "AVX2"}};
+
+        cout << "InternetChecksum throughput\n";
+        for (const size_t size : {20u, 40u, 64u, 256u, 576u, 1452u, 4096u, 16384u, 65536u}) {
+            const string_view payload = string_view{data}.substr(0, size);
+            const uint16_t expected = benchmark("byte", payload, [] { return ByteChecksum{}; });
+            for (const auto &[kernel, name] : kernels) {
+                if (InternetChecksum::supported(kernel) and
+                    benchmark(name, payload, [kernel = kernel] { return InternetChecksum{0, kernel}; }) != expected) {
+                    throw runtime_error("the " + name + " kernel computed a different checksum");
+                }
+            }
+        }
+
+        cout << "\nTCPSegment serialization into a contiguous packet\n";
+        for (const size_t size : {64u, 576u, 1452u, 16384u}) {
+            const Buffer payload{data.substr(0, size)};
+            const string expected = benchmark_serialize(
+                "concatenate", payload, [](const TCPSegment &seg, string &packet) {
+                    packet = seg.serialize().concatenate();
+                });
+            const string fused = benchmark_serialize(
+                "serialize_into", payload, [](const TCPSegment &seg, string &packet) {
+                    packet.clear();
+                    seg.serialize_into(packet);
+                });
+            if (fused != expected) {
+                throw runtime_error("serialize_into() gave a different packet");
+            }
+        }
+
+        cout << "\nTCPHeader serialization\n";
+        const uint8_t from_string = benchmark_header("serialize", [](const TCPHeader &header) {
+            return uint8_t(header.serialize()[7]);
+        });
+        array<uint8_t, TCPHeader::LENGTH + TCPHeader::MAX_OPTIONS_LENGTH> storage{};
+        const uint8_t from_storage = benchmark_header("serialize_into", [&storage](const TCPHeader &header) {
+            header.serialize_into(storage.data(), storage.size());
+            return storage[7];
+        });
+        if (from_string != from_storage) {
+            throw runtime_error("serialize_into() gave a different header");
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
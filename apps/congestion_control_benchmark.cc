@@ -0,0 +1,132 @@
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <limits>
+#include <queue>
+#include <string>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t HEADER_BYTES = 40;  // IPv4 + TCP headers, without options
+static constexpr uint64_t DURATION_MS = 30'000;
+
+//! A single bottleneck: a drop-tail queue drained at a fixed rate, plus a fixed propagation delay each way
+struct Bottleneck {
+    size_t bytes_per_ms;
+    uint64_t one_way_delay_ms;
+    size_t queue_limit;
+};
+
+//! An acknowledgment on its way back to the sender
+struct Ack {
+    uint64_t arrival_ms;
+    WrappingInt32 ackno;
+    uint16_t window;
+    vector<SACKBlock> sack_blocks;
+};
+
+//! Send a bulk transfer through `link` for DURATION_MS, one millisecond at a time
+void simulate(const string &name, const TCPConfig::CongestionControl algorithm, const Bottleneck &link) {
+    TCPConfig config;
+    config.congestion_control = algorithm;
+    config.fast_retransmit = true;
+    config.adaptive_rto = true;
+    config.sack = true;
+    config.fixed_isn = WrappingInt32{0};
+    TCPSender sender{config};
+    TCPReceiver receiver{config.recv_capacity};
+
+    queue<TCPSegment> bottleneck_queue;  // segments waiting for the bottleneck link
+    size_t queued_bytes = 0;
+    queue<pair<uint64_t, TCPSegment>> data_in_flight;  // (arrival time, segment)
+    queue<Ack> acks_in_flight;
+
+    const string data(config.send_capacity, 'x');
+    size_t link_credit = 0;
+    size_t delivered = 0, drops = 0, segments_sent = 0, max_queued = 0;
+    double queue_sum = 0;
+
+    for (uint64_t now = 0; now < DURATION_MS; ++now) {
+        while (not acks_in_flight.empty() and acks_in_flight.front().arrival_ms <= now) {
+            const Ack &ack = acks_in_flight.front();
+            sender.ack_received(ack.ackno, ack.window, ack.sack_blocks);
+            acks_in_flight.pop();
+        }
+        sender.tick(1);
+
+        sender.stream_in().write(data.substr(0, sender.stream_in().remaining_capacity()));
+        sender.fill_window();
+        while (not sender.segments_out().empty()) {
+            TCPSegment &seg = sender.segments_out().front();
+            const size_t wire_bytes = HEADER_BYTES + seg.payload().size();
+            ++segments_sent;
+            if (queued_bytes + wire_bytes > link.queue_limit) {
+                ++drops;
+            } else {
+                queued_bytes += wire_bytes;
+                bottleneck_queue.push(move(seg));
+            }
+            sender.segments_out().pop();
+        }
+
+        // the link sends whole segments, carrying over any unused credit while there is a backlog
+        link_credit += link.bytes_per_ms;
+        while (not bottleneck_queue.empty() and
+               link_credit >= HEADER_BYTES + bottleneck_queue.front().payload().size()) {
+            const size_t wire_bytes = HEADER_BYTES + bottleneck_queue.front().payload().size();
+            link_credit -= wire_bytes;
+            queued_bytes -= wire_bytes;
+            data_in_flight.emplace(now + link.one_way_delay_ms, move(bottleneck_queue.front()));
+            bottleneck_queue.pop();
+        }
+        if (bottleneck_queue.empty()) {
+            link_credit = 0;
+        }
+        queue_sum += queued_bytes;
+        max_queued = max(max_queued, queued_bytes);
+
+        while (not data_in_flight.empty() and data_in_flight.front().first <= now) {
+            receiver.segment_received(data_in_flight.front().second);
+            data_in_flight.pop();
+            const uint16_t window = min(receiver.window_size(), size_t{numeric_limits<uint16_t>::max()});
+            acks_in_flight.push(
+                {now + link.one_way_delay_ms, receiver.ackno().value(), window, receiver.sack_blocks()});
+        }
+        delivered += receiver.stream_out().buffer_size();
+        receiver.stream_out().pop_output(receiver.stream_out().buffer_size());
+    }
+
+    const double goodput = 8.0 * delivered / DURATION_MS / 1e3;
+    const double capacity = 8.0 * link.bytes_per_ms / 1e3;
+    cout << "  " << left << setw(6) << name << right << fixed << setprecision(2) << setw(7) << goodput
+         << " Mbit/s goodput (" << setw(5) << setprecision(1) << 100 * goodput / capacity << "% of link), queue avg "
+         << setw(6) << queue_sum / DURATION_MS / 1e3 << " kB, max " << setw(5) << max_queued / 1e3 << " kB, "
+         << setw(5) << drops << " of " << setw(6) << segments_sent << " segments dropped\n";
+}
+
+int main() {
+    try {
+        const size_t bytes_per_ms = 500;  // 4 Mbit/s
+        const uint64_t delay = 20;        // 40 ms round trip, so the bandwidth-delay product is 20 kB
+        for (const size_t queue_limit : {size_t{16'000}, size_t{64'000}}) {
+            cout << "4 Mbit/s bottleneck, 40 ms RTT, " << queue_limit / 1000 << " kB drop-tail queue, "
+                 << DURATION_MS / 1000 << " s bulk transfer\n";
+            const Bottleneck link{bytes_per_ms, delay, queue_limit};
+            simulate("none", TCPConfig::CongestionControl::None, link);
+            simulate("Reno", TCPConfig::CongestionControl::Reno, link);
+            simulate("CUBIC", TCPConfig::CongestionControl::Cubic, link);
+            simulate("BBR", TCPConfig::CongestionControl::BBR, link);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
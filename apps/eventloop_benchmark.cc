@@ -0,0 +1,66 @@
+#include "eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <vector>
+
+using namespace std;
+
+//! Time one iteration of an EventLoop with `idle` fds that never become ready and one that always does
+static void run(const string &name, const EventLoop::Backend backend, const size_t idle) {
+    EventLoop loop{backend};
+
+    // the idle fds: eventfds that nothing ever writes to
+    vector<FileDescriptor> idle_fds;
+    idle_fds.reserve(idle);
+    for (size_t i = 0; i < idle; i++) {
+        idle_fds.emplace_back(SystemCall("eventfd", eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)));
+        FileDescriptor &fd = idle_fds.back();
+        loop.add_rule(fd, Direction::In, [&fd] { fd.read(); });
+    }
+
+    // the active fd: one end of a socket pair, with a byte written to the other end before each iteration
+    array<int, 2> fds{};
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+    LocalStreamSocket active{FileDescriptor(fds[0])}, peer{FileDescriptor(fds[1])};
+    loop.add_rule(active, Direction::In, [&] { active.read(); });
+
+    const size_t iterations = idle >= 1000 ? 2000 : 200000;
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < iterations; i++) {
+        peer.write("x");
+        if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+            throw runtime_error("EventLoop stopped early");
+        }
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double microseconds = chrono::duration<double, micro>(duration).count() / iterations;
+    cout << "  " << left << setw(6) << name << right << setw(6) << idle << " idle fds: " << fixed << setprecision(2)
+         << setw(8) << microseconds << " us/iteration\n";
+}
+
+int main() {
+    try {
+        cout << "EventLoop iterations with one active fd\n";
+        for (const size_t idle : {0u, 100u, 1000u, 10000u}) {
+            run("poll", EventLoop::Backend::Poll, idle);
+            run("epoll", EventLoop::Backend::Epoll, idle);
+            run("uring", EventLoop::Backend::IoUring, idle);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
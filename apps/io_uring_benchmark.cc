@@ -0,0 +1,150 @@
+#include "eventloop.hh"
+#include "io_uring.hh"
+#include "socket.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Number of UDP sockets, each of which gets one datagram per round
+static constexpr size_t SOCKETS = 256;
+
+//! Rounds to time
+static constexpr size_t ROUNDS = 2000;
+
+//! Size of each datagram
+static constexpr size_t DATAGRAM_SIZE = 64;
+
+//! Connected pairs of UDP sockets
+struct Sockets {
+    vector<UDPSocket> receivers, senders;
+
+    Sockets() : receivers(SOCKETS), senders(SOCKETS) {
+        for (size_t i = 0; i < SOCKETS; i++) {
+            receivers[i].bind({"127.0.0.1", 0});
+            senders[i].connect(receivers[i].local_address());
+            receivers[i].connect(senders[i].local_address());
+        }
+    }
+
+    //! Send one datagram to each receiver
+    void send_all() {
+        const string datagram(DATAGRAM_SIZE, 'x');
+        for (auto &sender : senders) {
+            sender.write(datagram);
+        }
+    }
+};
+
+static void print(const string &name, const chrono::steady_clock::duration duration) {
+    const double microseconds = chrono::duration<double, micro>(duration).count() / ROUNDS;
+    cout << "  " << left << setw(34) << name << right << fixed << setprecision(2) << setw(8) << microseconds
+         << " us/round (" << setprecision(0) << setw(4) << microseconds * 1000 / SOCKETS << " ns/datagram)\n";
+}
+
+//! Receive each round's datagrams with an EventLoop whose callbacks read(2) them
+static void receive_with_eventloop(const string &name, const EventLoop::Backend backend) {
+    Sockets sockets;
+    EventLoop loop{backend};
+    size_t received = 0;
+    string datagram;
+    for (auto &receiver : sockets.receivers) {
+        loop.add_rule(receiver, Direction::In, [&] {
+            receiver.read(datagram, DATAGRAM_SIZE);
+            received++;
+        });
+    }
+
+    chrono::steady_clock::duration duration{};
+    for (size_t round = 0; round < ROUNDS; round++) {
+        sockets.send_all();
+        const auto start = chrono::steady_clock::now();
+        for (received = 0; received < SOCKETS;) {
+            if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+                throw runtime_error("EventLoop stopped early");
+            }
+        }
+        duration += chrono::steady_clock::now() - start;
+    }
+    print(name, duration);
+}
+
+//! Receive each round's datagrams with a batch of io_uring reads into registered buffers
+static void receive_with_io_uring() {
+    Sockets sockets;
+    // (each round's buffers are still held, by the last round's results, while its reads are queued)
+    IoUring ring{SOCKETS, 2 * SOCKETS, DATAGRAM_SIZE};
+
+    chrono::steady_clock::duration duration{};
+    for (size_t round = 0; round < ROUNDS; round++) {
+        sockets.send_all();
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < SOCKETS; i++) {
+            ring.read(sockets.receivers[i], i);
+        }
+        if (ring.submit(SOCKETS).size() != SOCKETS) {
+            throw runtime_error("missing completions");
+        }
+        duration += chrono::steady_clock::now() - start;
+    }
+    print(string("io_uring batched reads") + (ring.registered_buffers() ? " (fixed)" : ""), duration);
+}
+
+//! Send one datagram on each socket per round, with write(2) or with a batch of io_uring writes
+static void send(const bool batched) {
+    Sockets sockets;
+    IoUring ring{SOCKETS, SOCKETS, DATAGRAM_SIZE};
+    const string datagram(DATAGRAM_SIZE, 'x');
+    string discard;
+
+    chrono::steady_clock::duration duration{};
+    for (size_t round = 0; round < ROUNDS; round++) {
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < SOCKETS; i++) {
+            if (batched) {
+                ring.write(sockets.senders[i], datagram, i);
+            } else {
+                sockets.senders[i].write(datagram);
+            }
+        }
+        if (batched and ring.submit(SOCKETS).size() != SOCKETS) {
+            throw runtime_error("missing completions");
+        }
+        duration += chrono::steady_clock::now() - start;
+
+        for (auto &receiver : sockets.receivers) {
+            receiver.read(discard, DATAGRAM_SIZE);
+        }
+    }
+    print(batched ? "io_uring batched writes" : "write(2)", duration);
+}
+
+int main() {
+    try {
+        if (not IoUring::available()) {
+            cout << "io_uring is not available here (EventLoop::Backend::IoUring would use epoll)\n";
+            return EXIT_SUCCESS;
+        }
+
+        cout << "Receiving a " << DATAGRAM_SIZE << "-byte datagram on each of " << SOCKETS << " UDP sockets\n";
+        receive_with_eventloop("poll + read(2)", EventLoop::Backend::Poll);
+        receive_with_eventloop("epoll + read(2)", EventLoop::Backend::Epoll);
+        receive_with_eventloop("io_uring poll + read(2)", EventLoop::Backend::IoUring);
+        receive_with_io_uring();
+
+        cout << "Sending a " << DATAGRAM_SIZE << "-byte datagram on each of " << SOCKETS << " UDP sockets\n";
+        send(false);
+        send(true);
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
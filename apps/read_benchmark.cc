@@ -0,0 +1,94 @@
+#include "socket.hh"
+#include "util.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+
+using namespace std;
+
+//! Size of each packet, like a full-sized packet from a TUN device
+static constexpr size_t PACKET_SIZE = 1500;
+
+//! Packets sent before each batch of reads (few enough to fit in the socket's buffer)
+static constexpr size_t BATCH = 64;
+
+//! Batches to time
+static constexpr size_t BATCHES = 2000;
+
+//! Time reading `BATCH` packets, `BATCHES` times, with `read_one`
+template <typename Write, typename Read>
+static void run(const string &name, Write &&write_one, Read &&read_one) {
+    chrono::steady_clock::duration duration{};
+    for (size_t batch = 0; batch < BATCHES; batch++) {
+        for (size_t i = 0; i < BATCH; i++) {
+            write_one();
+        }
+        const auto start = chrono::steady_clock::now();
+        for (size_t i = 0; i < BATCH; i++) {
+            if (read_one() != PACKET_SIZE) {
+                throw runtime_error("short read");
+            }
+        }
+        duration += chrono::steady_clock::now() - start;
+    }
+
+    const double nanoseconds = chrono::duration<double, nano>(duration).count() / (BATCH * BATCHES);
+    cout << "  " << left << setw(42) << name << right << fixed << setprecision(0) << setw(7) << nanoseconds
+         << " ns/packet\n";
+}
+
+int main() {
+    try {
+        const string packet(PACKET_SIZE, 'x');
+
+        // a datagram socket pair, which hands out one packet per read as a TUN device does
+        {
+            array<int, 2> fds{};
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds.data()));
+            FileDescriptor reader{fds[0]}, writer{fds[1]};
+            const auto write_one = [&] { writer.write(packet); };
+
+            cout << "Reading " << PACKET_SIZE << "-byte packets from a file descriptor\n";
+            run("FileDescriptor::read()", write_one, [&] { return reader.read().size(); });
+            string reused;
+            run("FileDescriptor::read(string &)", write_one, [&] {
+                reader.read(reused);
+                return reused.size();
+            });
+            run("FileDescriptor::read_buffer()", write_one, [&] { return reader.read_buffer().size(); });
+            PacketBuffer provided;
+            run("FileDescriptor::read_buffer(PacketBuffer)", write_one, [&] {
+                // (the caller picks the block: here, one just big enough for a full-sized packet)
+                provided = PacketBuffer{PACKET_SIZE};
+                return reader.read_buffer(provided).size();
+            });
+        }
+
+        {
+            UDPSocket receiver, sender;
+            receiver.bind({"127.0.0.1", 0});
+            sender.connect(receiver.local_address());
+            const auto write_one = [&] { sender.send(packet); };
+
+            cout << "Receiving " << PACKET_SIZE << "-byte datagrams from a UDP socket\n";
+            run("UDPSocket::recv()", write_one, [&] { return receiver.recv().payload.size(); });
+            UDPSocket::received_datagram reused{{nullptr, 0}, {}};
+            run("UDPSocket::recv(received_datagram &)", write_one, [&] {
+                receiver.recv(reused);
+                return reused.payload.size();
+            });
+            run("UDPSocket::recv_buffer()", write_one, [&] { return receiver.recv_buffer().payload.size(); });
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
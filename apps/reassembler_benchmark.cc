@@ -0,0 +1,76 @@
+#include "stream_reassembler.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+
+using namespace std;
+
+static constexpr size_t MAX_SEG_LEN = 1452;
+static constexpr size_t MAX_OVERLAP = 512;
+
+//! Cut a stream of `n_segments` segments into overlapping pieces and deliver them in random order
+void benchmark(const size_t n_segments) {
+    auto rd = get_random_generator();
+
+    vector<tuple<size_t, size_t>> seq_size;
+    size_t offset = 0;
+    for (size_t i = 0; i < n_segments; ++i) {
+        const size_t size = 1 + (rd() % (MAX_SEG_LEN - 1));
+        const size_t offs = min(offset, static_cast<size_t>(rd()) % MAX_OVERLAP);
+        seq_size.emplace_back(offset - offs, size + offs);
+        offset += size;
+    }
+    shuffle(seq_size.begin(), seq_size.end(), rd);
+
+    string d(offset, 0);
+    generate(d.begin(), d.end(), [&] { return rd(); });
+
+    vector<string> segments;
+    segments.reserve(seq_size.size());
+    for (const auto &[off, sz] : seq_size) {
+        segments.emplace_back(d.cbegin() + off, d.cbegin() + off + sz);
+    }
+
+    StreamReassembler reassembler{offset};
+    size_t max_unassembled = 0;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t i = 0; i < segments.size(); ++i) {
+        const auto [off, sz] = seq_size[i];
+        reassembler.push_substring(segments[i], off, off + sz == offset);
+        max_unassembled = max(max_unassembled, reassembler.unassembled_bytes());
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    if (reassembler.stream_out().read(offset) != d or not reassembler.stream_out().eof()) {
+        throw runtime_error("reassembled stream does not match the original");
+    }
+
+    const double seconds = chrono::duration<double>(duration).count();
+    cout << "  " << setw(7) << n_segments << " segments (" << setw(9) << offset << " bytes, peak " << setw(9)
+         << max_unassembled << " unassembled): " << fixed << setprecision(2) << setw(8)
+         << n_segments / seconds / 1e3 << " k segments/s, " << setw(8) << 8.0 * offset / seconds / 1e9
+         << " Gbit/s\n";
+}
+
+int main() {
+    try {
+        cout << "StreamReassembler with random-order, overlapping segments\n";
+        for (const size_t n_segments : {100u, 1000u, 10000u, 50000u}) {
+            benchmark(n_segments);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,100 @@
+#include "sharded_eventloop.hh"
+#include "socket.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! Size of each message that a client sends and waits to have echoed back
+static constexpr size_t MESSAGE_SIZE = 16384;
+
+//! Round trips made by each client
+static constexpr size_t ROUND_TRIPS = 5000;
+
+//! Clients per shard, so that each shard always has work while its clients wait for their echoes
+static constexpr size_t CLIENTS_PER_SHARD = 4;
+
+//! Echo `ROUND_TRIPS` messages on each of `clients` connections to a server with `shards` shards
+static double run(const size_t shards, const size_t clients) {
+    ShardedEventLoop runtime{shards};
+
+    TCPSocket listener;
+    listener.set_reuseaddr();
+    listener.bind({"127.0.0.1", 0});
+    listener.listen(static_cast<int>(clients));
+
+    // the server: each connection echoes back whatever arrives on it, on the shard that its flow hash picks
+    thread acceptor{[&] {
+        for (size_t i = 0; i < clients; i++) {
+            runtime.assign(listener.accept(), [](EventLoop &loop, shared_ptr<TCPSocket> socket) {
+                loop.add_rule(*socket, Direction::In, [socket] { socket->write(socket->read()); });
+            });
+        }
+    }};
+
+    // the clients, one thread each
+    vector<TCPSocket> sockets(clients);
+    for (auto &socket : sockets) {
+        socket.connect(listener.local_address());
+    }
+    acceptor.join();
+
+    const auto start = chrono::steady_clock::now();
+    vector<thread> client_threads;
+    for (auto &socket : sockets) {
+        client_threads.emplace_back([&socket] {
+            const string message(MESSAGE_SIZE, 'x');
+            string echoed;
+            for (size_t i = 0; i < ROUND_TRIPS; i++) {
+                socket.write(message);
+                for (size_t received = 0; received < MESSAGE_SIZE; received += echoed.size()) {
+                    socket.read(echoed, MESSAGE_SIZE - received);
+                }
+            }
+        });
+    }
+    for (auto &client : client_threads) {
+        client.join();
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double bytes = 2.0 * clients * ROUND_TRIPS * MESSAGE_SIZE;
+    return bytes * 8 / chrono::duration<double>(duration).count() / 1e9;
+}
+
+int main(int argc, char *argv[]) {
+    try {
+        if (argc > 2) {
+            cerr << "Usage: " << argv[0] << " [MAX_SHARDS]\n";
+            return EXIT_FAILURE;
+        }
+        const size_t cores = max(1u, thread::hardware_concurrency());
+        const size_t max_shards = argc == 2 ? stoul(argv[1]) : cores;
+        cout << "Echoing " << MESSAGE_SIZE << "-byte messages over loopback, " << CLIENTS_PER_SHARD
+             << " clients per shard, on " << cores << " core" << (cores == 1 ? "" : "s") << "\n";
+
+        double one_shard = 0;
+        for (size_t shards = 1; shards <= max_shards; shards *= 2) {
+            const double gbps = run(shards, CLIENTS_PER_SHARD * shards);
+            one_shard = shards == 1 ? gbps : one_shard;
+            cout << "  " << setw(3) << shards << " shard" << (shards == 1 ? " " : "s") << ": " << fixed
+                 << setprecision(2) << setw(7) << gbps << " Gbit/s (" << setprecision(2) << gbps / one_shard
+                 << "x one shard)\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+#include "parser.hh"
+#include "tcp_config.hh"
+#include "tcp_header.hh"
+#include "tcp_segment.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+
+using namespace std;
+
+//! A TCP segment from the corpus, and the pseudo-header sum that its checksum covers
+struct Sample {
+    Buffer segment;
+    uint32_t pseudo_sum;
+};
+
+//! Read a 16- or 32-bit field of a pcap file, which is in the byte order of whoever wrote the file
+static uint32_t pcap_field(const string &file, const size_t offset, const size_t size, const bool swapped) {
+    uint32_t val = 0;
+    for (size_t i = 0; i < size; i++) {
+        const size_t byte = swapped ? offset + i : offset + size - 1 - i;
+        val = (val << 8) | uint8_t(file.at(byte));
+    }
+    return val;
+}
+
+//! \brief The TCP segments in IPv4-over-Ethernet frames of a classic pcap file
+//! \details Frames are picked out the same way as in tests/tcp_parser.cc, but the file is read directly
+//! so that the benchmark doesn't need libpcap.
+static vector<Sample> read_pcap(const string &filename) {
+    ifstream in{filename, ios::binary};
+    if (not in) {
+        throw runtime_error("cannot open " + filename);
+    }
+    const string file{istreambuf_iterator<char>(in), istreambuf_iterator<char>()};
+
+    constexpr size_t GLOBAL_HEADER_LENGTH = 24, RECORD_HEADER_LENGTH = 16, ETHERNET_HEADER_LENGTH = 14;
+    const uint32_t magic = pcap_field(file, 0, 4, false);
+    const bool swapped = magic == 0xd4c3b2a1 or magic == 0x4d3cb2a1;
+    if (not swapped and magic != 0xa1b2c3d4 and magic != 0xa1b23c4d) {
+        throw runtime_error(filename + " is not a pcap file");
+    }
+    if (pcap_field(file, 20, 4, swapped) != 1) {
+        throw runtime_error("expected ethernet linktype in " + filename);
+    }
+
+    vector<Sample> samples;
+    for (size_t offset = GLOBAL_HEADER_LENGTH; offset + RECORD_HEADER_LENGTH <= file.size();) {
+        const size_t caplen = pcap_field(file, offset + 8, 4, swapped);
+        const string_view frame = string_view{file}.substr(offset + RECORD_HEADER_LENGTH, caplen);
+        offset += RECORD_HEADER_LENGTH + caplen;
+
+        const auto byte = [&](const size_t i) -> uint32_t { return uint8_t(frame[i]); };
+        if (frame.size() < ETHERNET_HEADER_LENGTH + 20 or byte(12) != 0x08 or byte(13) != 0x00 or byte(23) != 6) {
+            continue;  // not TCP over IPv4
+        }
+        const size_t hdrlen = (byte(14) & 0x0f) << 2;
+        const size_t tlen = (byte(16) << 8) | byte(17);
+        if (frame.size() - ETHERNET_HEADER_LENGTH != tlen or tlen < hdrlen) {
+            continue;  // truncated segment
+        }
+
+        const size_t tcp_seg_len = tlen - hdrlen;
+        uint32_t pseudo_sum = ((byte(26) << 8) | byte(27)) + ((byte(28) << 8) | byte(29));  // src addr
+        pseudo_sum += ((byte(30) << 8) | byte(31)) + ((byte(32) << 8) | byte(33));          // dst addr
+        pseudo_sum += byte(23) + tcp_seg_len;                                                // proto, len
+        samples.push_back({string(frame.substr(ETHERNET_HEADER_LENGTH + hdrlen)), pseudo_sum});
+    }
+    return samples;
+}
+
+//! Random segments: mostly full-sized data segments, plus bare ACKs, some with timestamps and SACK options
+static vector<Sample> synthetic_corpus() {
+    auto rd = get_random_generator();
+    vector<Sample> samples;
+    for (size_t i = 0; i < 4096; i++) {
+        TCPSegment seg;
+        TCPHeader &header = seg.header();
+        header.sport = static_cast<uint16_t>(rd());
+        header.dport = static_cast<uint16_t>(rd());
+        header.seqno = WrappingInt32(static_cast<uint32_t>(rd()));
+        header.ackno = WrappingInt32(static_cast<uint32_t>(rd()));
+        header.ack = true;
+        header.win = static_cast<uint16_t>(rd());
+        if (i % 2) {
+            header.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+        }
+        if (i % 8 == 1) {
+            header.sack_blocks.push_back({header.ackno + 1000, header.ackno + 2000});
+        }
+        header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+        if (i % 4) {
+            seg.set_payload(string(TCPConfig::MAX_PAYLOAD_SIZE, static_cast<char>(rd())));
+        }
+
+        const uint32_t pseudo_sum = uniform_int_distribution<uint32_t>{0, 0x3'ffff}(rd);
+        samples.push_back({seg.serialize(pseudo_sum).concatenate(), pseudo_sum});
+    }
+    return samples;
+}
+
+//! Parse every sample over and over, and report the time per segment
+template <typename Parse>
+void benchmark(const string &name, const vector<Sample> &samples, Parse &&parse) {
+    const size_t rounds = max<size_t>(1, (size_t{1} << 23) / samples.size());
+    size_t errors = 0;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t round = 0; round < rounds; round++) {
+        for (const auto &sample : samples) {
+            errors += parse(sample) != ParseResult::NoError;
+        }
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double nanoseconds = chrono::duration<double, nano>(duration).count() / (rounds * samples.size());
+    cout << "  " << left << setw(18) << name << right << fixed << setprecision(1) << setw(7) << nanoseconds
+         << " ns/segment, " << setprecision(2) << setw(6) << 1e3 / nanoseconds << " Mpps\n";
+    if (errors > 0) {
+        throw runtime_error(name + ": " + to_string(errors / rounds) + " segments failed to parse");
+    }
+}
+
+int main(int argc, char **argv) {
+    try {
+        if (argc > 2) {
+            cerr << "Usage: " << argv[0] << " [capture.pcap]\n";
+            return EXIT_FAILURE;
+        }
+
+        const vector<Sample> samples = argc == 2 ? read_pcap(argv[1]) : synthetic_corpus();
+        if (samples.empty()) {
+            throw runtime_error("no TCP segments to parse");
+        }
+        cout << "Parsing " << samples.size() << " TCP segments" << (argc == 2 ? " from " + string(argv[1]) : "")
+             << "\n";
+
+        benchmark("TCPHeader::parse", samples, [](const Sample &sample) {
+            NetParser p{sample.segment};
+            TCPHeader header;
+            return header.parse(p);
+        });
+        benchmark("TCPSegment::parse", samples, [](const Sample &sample) {
+            TCPSegment seg;
+            return seg.parse(sample.segment, sample.pseudo_sum);
+        });
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
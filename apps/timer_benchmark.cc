@@ -0,0 +1,107 @@
+#include "tcp_sender.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Number of retransmission timers, one per connection
+static constexpr size_t TIMERS = 100000;
+
+//! Milliseconds of simulated time
+static constexpr uint64_t DURATION_MS = 2000;
+
+//! Timers that start out running, each with an RTO of 200 ms to 60 s
+static vector<TCPTimer> make_timers() {
+    mt19937 rd{1};
+    vector<TCPTimer> timers;
+    timers.reserve(TIMERS);
+    for (size_t i = 0; i < TIMERS; i++) {
+        timers.emplace_back(200 + rd() % 59800);
+    }
+    return timers;
+}
+
+//! Time a run of DURATION_MS milliseconds, one tick at a time
+template <typename Tick>
+static void run(const string &name, Tick &&tick) {
+    size_t expirations = 0;
+    const auto start = chrono::steady_clock::now();
+    for (uint64_t now = 1; now <= DURATION_MS; now++) {
+        expirations += tick(now);
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double microseconds = chrono::duration<double, micro>(duration).count() / DURATION_MS;
+    cout << "  " << left << setw(34) << name << right << fixed << setprecision(2) << setw(9) << microseconds
+         << " us per ms of time (" << expirations << " expirations)\n";
+}
+
+int main() {
+    try {
+        cout << TIMERS << " running retransmission timers, over " << DURATION_MS << " ms\n";
+
+        // every timer is told about every millisecond, and asked whether it has expired
+        {
+            vector<TCPTimer> timers = make_timers();
+            for (auto &timer : timers) {
+                timer.start(timer.get_rto());
+            }
+            run("polled: add(1) and is_expired()", [&](uint64_t) {
+                size_t expired = 0;
+                for (auto &timer : timers) {
+                    timer.add(1);
+                    if (timer.is_expired()) {
+                        timer.restart();
+                        expired++;
+                    }
+                }
+                return expired;
+            });
+        }
+
+        // each timer keeps a timer armed on a wheel, and the wheel is told about every millisecond
+        {
+            TimerWheel wheel;
+            vector<TCPTimer> timers = make_timers();
+            size_t expired = 0;
+            for (auto &timer : timers) {
+                timer.set_wheel(wheel, [&timer, &expired] {
+                    timer.restart();
+                    expired++;
+                });
+                timer.start(timer.get_rto());
+            }
+            run("wheel: advance()", [&](const uint64_t now) {
+                expired = 0;
+                wheel.advance(now);
+                return expired;
+            });
+
+            // restarting a timer cancels its wheel timer and arms another
+            mt19937 rd{2};
+            constexpr size_t RESTARTS = 1000000;
+            const auto start = chrono::steady_clock::now();
+            for (size_t i = 0; i < RESTARTS; i++) {
+                timers[rd() % TIMERS].restart();
+            }
+            const auto duration = chrono::steady_clock::now() - start;
+            cout << "  " << left << setw(34) << "wheel: restart()" << right << fixed << setprecision(2) << setw(9)
+                 << chrono::duration<double, nano>(duration).count() / RESTARTS << " ns per restart (" << wheel.size()
+                 << " armed)\n";
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
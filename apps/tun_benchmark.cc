@@ -0,0 +1,185 @@
+#include "eventloop.hh"
+#include "sharded_eventloop.hh"
+#include "socket.hh"
+#include "tun.hh"
+#include "util.hh"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <linux/if.h>
+#include <memory>
+#include <netinet/in.h>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+//! Number of UDP flows sent out through the device
+static constexpr uint16_t FLOWS = 256;
+
+//! Packets sent before each batch of reads (few enough to fit in the device's queues)
+static constexpr size_t BATCH = 256;
+
+//! Batches to time
+static constexpr size_t BATCHES = 1000;
+
+//! Size of each UDP payload
+static constexpr size_t PAYLOAD_SIZE = 1400;
+
+//! Give the device (whose /24 is 10.144.`subnet`.0) its address and bring it up
+static void configure(const string &devname, const unsigned subnet) {
+    FileDescriptor sock{SystemCall("socket", ::socket(AF_INET, SOCK_DGRAM, 0))};
+    struct ifreq req {};
+    strncpy(static_cast<char *>(req.ifr_name), devname.c_str(), IFNAMSIZ - 1);
+
+    const auto set_address = [&](const unsigned long request, const string &address) {
+        sockaddr_in sin{};
+        sin.sin_family = AF_INET;
+        inet_pton(AF_INET, address.c_str(), &sin.sin_addr);
+        memcpy(&req.ifr_addr, &sin, sizeof(sin));
+        SystemCall("ioctl", ioctl(sock.fd_num(), request, &req));
+    };
+    set_address(SIOCSIFADDR, "10.144." + to_string(subnet) + ".1");
+    set_address(SIOCSIFNETMASK, "255.255.255.0");
+
+    SystemCall("ioctl", ioctl(sock.fd_num(), SIOCGIFFLAGS, &req));
+    req.ifr_flags |= IFF_UP;
+    SystemCall("ioctl", ioctl(sock.fd_num(), SIOCSIFFLAGS, &req));
+}
+
+//! UDP sockets, one per flow, that send out through the device of 10.144.`subnet`.0/24
+struct Senders {
+    vector<UDPSocket> sockets;
+    string payload = string(PAYLOAD_SIZE, 'x');
+
+    explicit Senders(const unsigned subnet) : sockets(FLOWS) {
+        for (uint16_t flow = 0; flow < FLOWS; flow++) {
+            sockets[flow].connect({"10.144." + to_string(subnet) + ".2", uint16_t(1024 + flow)});
+        }
+    }
+
+    //! Send BATCH packets, spread across the flows
+    void send_batch() {
+        for (size_t i = 0; i < BATCH; i++) {
+            sockets[i % FLOWS].write(payload);
+        }
+    }
+};
+
+static void print(const string &name, const chrono::steady_clock::duration duration, const size_t wakeups) {
+    const double nanoseconds = chrono::duration<double, nano>(duration).count() / (BATCH * BATCHES);
+    cout << "  " << left << setw(40) << name << right << fixed << setprecision(0) << setw(7) << nanoseconds
+         << " ns/packet, " << setprecision(1) << setw(5) << double(BATCH * BATCHES) / wakeups << " packets/wakeup\n";
+}
+
+//! Read each batch from one queue with an EventLoop whose callback reads one packet, or up to `max_packets`
+static void read_one_queue(const string &name, const size_t max_packets) {
+    TunFD queue{"tun1"};
+    configure("tun1", 1);
+    queue.set_blocking(false);
+    Senders senders{1};
+    EventLoop loop{EventLoop::Backend::Epoll};
+    size_t received = 0, wakeups = 0;
+    vector<Buffer> packets;
+    loop.add_rule(queue, Direction::In, [&] {
+        packets.clear();
+        if (max_packets == 1) {
+            packets.push_back(queue.read_packet());
+        } else {
+            queue.read_packets(packets, max_packets);
+        }
+        for (const auto &packet : packets) {
+            received += packet.size() > PAYLOAD_SIZE;  // (not the kernel's own IPv6 packets)
+        }
+        wakeups++;
+    });
+
+    chrono::steady_clock::duration duration{};
+    for (size_t batch = 0; batch < BATCHES; batch++) {
+        senders.send_batch();
+        const auto start = chrono::steady_clock::now();
+        for (received = 0; received < BATCH;) {
+            if (loop.wait_next_event(-1) != EventLoop::Result::Success) {
+                throw runtime_error("EventLoop stopped early");
+            }
+        }
+        duration += chrono::steady_clock::now() - start;
+    }
+    print(name, duration, wakeups);
+}
+
+//! Read each batch from `queue_count` queues, each on a shard of its own
+static void read_queues(const size_t queue_count) {
+    const string devname = "mq" + to_string(queue_count);
+    auto queues = TunFD::open_queues(devname, queue_count);
+    configure(devname, unsigned(2 + queue_count));
+    Senders senders{unsigned(2 + queue_count)};
+    atomic<size_t> received{0}, wakeups{0};
+
+    chrono::steady_clock::duration duration{};
+    {
+        ShardedEventLoop runtime{queue_count};
+        for (size_t q = 0; q < queue_count; q++) {
+            queues[q].set_blocking(false);
+            auto queue = make_shared<TunFD>(move(queues[q]));
+            runtime.post(q, [queue, &received, &wakeups](EventLoop &loop) {
+                loop.add_rule(*queue, Direction::In, [queue, &received, &wakeups] {
+                    vector<Buffer> packets;
+                    queue->read_packets(packets);
+                    size_t count = 0;
+                    for (const auto &packet : packets) {
+                        count += packet.size() > PAYLOAD_SIZE;
+                    }
+                    received += count;
+                    wakeups++;
+                });
+            });
+        }
+
+        const auto start = chrono::steady_clock::now();
+        for (size_t batch = 1; batch <= BATCHES; batch++) {
+            senders.send_batch();
+            while (received < batch * BATCH) {
+                this_thread::yield();
+            }
+        }
+        duration = chrono::steady_clock::now() - start;
+    }
+    print(to_string(queue_count) + " queue(s), one shard each (send + read)", duration, wakeups);
+}
+
+int main() {
+    try {
+        // a network namespace of our own, so that the devices and their addresses go away when we exit
+        try {
+            SystemCall("unshare", ::unshare(CLONE_NEWNET));
+        } catch (const exception &e) {
+            cout << "can't create a network namespace (" << e.what() << "); this needs CAP_SYS_ADMIN\n";
+            return EXIT_SUCCESS;
+        }
+
+        cout << "Reading batches of " << BATCH << " " << PAYLOAD_SIZE << "-byte UDP packets from a TUN device\n";
+        read_one_queue("read_packet() per wakeup", 1);
+        read_one_queue("read_packets() per wakeup", 64);
+
+        cout << "Reading from the queues of a multi-queue TUN device, on " << thread::hardware_concurrency()
+             << " core(s)\n";
+        for (size_t queue_count = 1; queue_count <= max(4u, thread::hardware_concurrency()); queue_count *= 2) {
+            read_queues(queue_count);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
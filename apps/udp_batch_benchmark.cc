@@ -0,0 +1,141 @@
+#include "socket.hh"
+#include "tcp_config.hh"
+#include "tcp_segment.hh"
+#include "tcp_sender.hh"
+#include "util.hh"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Size of each datagram: a full-sized TCP segment on an Ethernet path
+static constexpr size_t DATAGRAM_SIZE = 1452;
+
+//! Number of datagrams sent in each run
+static constexpr size_t DATAGRAMS = 200000;
+
+//! Time `DATAGRAMS` datagrams sent and received over loopback, `batch_size` at a time
+template <typename Send, typename Receive>
+static void run(const string &name, const size_t batch_size, Send &&send, Receive &&receive) {
+    const auto start = chrono::steady_clock::now();
+    for (size_t sent = 0; sent < DATAGRAMS; sent += batch_size) {
+        send();
+        for (size_t received = 0; received < batch_size;) {
+            received += receive();
+        }
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double seconds = chrono::duration<double>(duration).count();
+    cout << "  " << left << setw(12) << name << right << setw(3) << batch_size << " datagrams/batch: " << fixed
+         << setprecision(2) << setw(6) << DATAGRAMS / seconds / 1e6 << " M datagrams/s\n";
+}
+
+//! The first `count` full-sized segments that a TCPSender sends, serialized
+static vector<BufferList> tcp_segments(const size_t count) {
+    TCPConfig config;
+    config.send_capacity = count * TCPConfig::MAX_PAYLOAD_SIZE;
+    TCPSender sender{config};
+    sender.stream_in().write(string(config.send_capacity, 'x'));
+
+    vector<BufferList> segments;
+    sender.fill_window();  // the SYN
+    sender.segments_out().pop();
+    while (segments.size() < count) {
+        sender.ack_received(sender.next_seqno(), 65535);
+        sender.fill_window();
+        for (; not sender.segments_out().empty(); sender.segments_out().pop()) {
+            segments.push_back(sender.segments_out().front().serialize());
+        }
+    }
+    segments.resize(count);
+    return segments;
+}
+
+//! Time segments from a TCPSender sent and received over loopback, and parsed on the way in
+template <typename Send>
+static void run_segments(const string &name,
+                         const vector<BufferViewList> &segments,
+                         UDPSocket &receiver,
+                         Send &&send) {
+    UDPSocket::received_batch batch{segments.size()};
+    TCPSegment segment;
+    size_t bytes = 0;
+
+    const auto start = chrono::steady_clock::now();
+    for (size_t sent = 0; sent < DATAGRAMS; sent += segments.size()) {
+        send();
+        for (size_t received = 0; received < segments.size();) {
+            receiver.recv_batch(batch);
+            for (size_t i = 0; i < batch.size(); i++, received++) {
+                if (segment.parse(string(batch.payload(i))) != ParseResult::NoError) {
+                    throw runtime_error("segment received corrupted");
+                }
+                bytes += segment.payload().size();
+            }
+        }
+    }
+    const auto duration = chrono::steady_clock::now() - start;
+
+    const double seconds = chrono::duration<double>(duration).count();
+    cout << "  " << left << setw(22) << name << right << fixed << setprecision(2) << setw(6)
+         << DATAGRAMS / seconds / 1e6 << " M segments/s, " << setw(6) << bytes * 8 / seconds / 1e9
+         << " Gbit/s of payload\n";
+}
+
+int main() {
+    try {
+        UDPSocket receiver;
+        receiver.bind(Address("127.0.0.1", 0));
+        UDPSocket sender;
+        sender.connect(receiver.local_address());
+        const string payload(DATAGRAM_SIZE, 'x');
+
+        cout << "Sending and receiving " << DATAGRAMS << " datagrams of " << DATAGRAM_SIZE
+             << " bytes over loopback\n";
+
+        // one system call per datagram
+        UDPSocket::received_datagram datagram{{nullptr, 0}, ""};
+        const auto send_one = [&] { sender.send(payload); };
+        const auto receive_one = [&] {
+            receiver.recv(datagram, DATAGRAM_SIZE);
+            return 1;
+        };
+        run("send/recv", 1, send_one, receive_one);
+
+        // one system call per batch
+        for (size_t batch_size = 1; batch_size <= 64; batch_size *= 2) {
+            const vector<BufferViewList> payloads(batch_size, BufferViewList{payload});
+            UDPSocket::received_batch batch{batch_size, DATAGRAM_SIZE};
+            const auto send_batch = [&] { sender.send_batch(payloads); };
+            const auto receive_batch = [&] { return receiver.recv_batch(batch); };
+            run("batched", batch_size, send_batch, receive_batch);
+        }
+
+        // segments from a TCPSender: one system call per batch, or one trip through the stack per train
+        const vector<BufferList> serialized = tcp_segments(44);
+        const vector<BufferViewList> segments(serialized.begin(), serialized.end());
+        cout << "Sending and receiving " << DATAGRAMS << " TCP segments over loopback, " << segments.size()
+             << " at a time\n";
+
+        UDPSocket gro_receiver;
+        gro_receiver.set_gro();
+        gro_receiver.bind(Address("127.0.0.1", 0));
+        UDPSocket gso_sender;
+        gso_sender.connect(gro_receiver.local_address());
+
+        run_segments("sendmmsg/recvmmsg", segments, receiver, [&] { sender.send_batch(segments); });
+        run_segments("GSO trains/GRO", segments, gro_receiver, [&] { gso_sender.send_trains(segments); });
+    } catch (const exception &e) {
+        cerr << e.what() << "\n";
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -7,6 +7,7 @@
 #include <cstdlib>
 #include <random>
 #include <stdexcept>
+#include <string>
 #include <sys/socket.h>
 #include <vector>
 
@@ -18,6 +19,10 @@ int main() {
 #include "socket_example_2.cc"
         } {
 #include "socket_example_3.cc"
+        } {
+#include "socket_example_4.cc"
+        } {
+#include "socket_example_5.cc"
         }
     } catch (...) {
         return EXIT_FAILURE;
@@ -0,0 +1,29 @@
+const uint16_t portnum = ((std::random_device()()) % 50000) + 1025;
+
+// create a UDP socket and bind it to a local address
+UDPSocket sock1;
+sock1.bind(Address("127.0.0.1", portnum));
+
+// send three datagrams to it with one system call
+UDPSocket sock2;
+const std::array<std::string, 3> payloads{"one", "two", "three"};
+std::vector<UDPSocket::outgoing_datagram> datagrams;
+for (const auto &payload : payloads) {
+    datagrams.push_back({Address("127.0.0.1", portnum), payload});
+}
+if (sock2.sendto_batch(datagrams) != payloads.size()) {
+    throw std::runtime_error("wrong number of datagrams sent");
+}
+
+// receive them into storage that is reused from one batch to the next
+UDPSocket::received_batch batch{16, 1500};
+size_t received = 0;
+while (received < payloads.size()) {
+    sock1.recv_batch(batch);
+    for (size_t i = 0; i < batch.size(); i++, received++) {
+        if (batch.payload(i) != payloads.at(received) ||
+            batch.source_address(i).port() != sock2.local_address().port()) {
+            throw std::runtime_error("wrong datagram received");
+        }
+    }
+}
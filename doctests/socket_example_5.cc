@@ -0,0 +1,26 @@
+// create a UDP socket that takes datagrams in trains, and bind it to a local address
+UDPSocket sock1;
+sock1.set_gro();
+sock1.bind(Address("127.0.0.1", 0));
+
+// send five datagrams as one train: all the same size, except the last
+UDPSocket sock2;
+sock2.connect(sock1.local_address());
+const std::array<std::string, 5> payloads{
+    std::string(1000, 'a'), std::string(1000, 'b'), std::string(1000, 'c'), std::string(1000, 'd'), "e"};
+const std::vector<BufferViewList> train(payloads.begin(), payloads.end());
+if (sock2.send_trains(train) != payloads.size()) {
+    throw std::runtime_error("wrong number of datagrams sent");
+}
+
+// receive them, split back into the datagrams they were sent as
+UDPSocket::received_batch batch{4};
+size_t received = 0;
+while (received < payloads.size()) {
+    sock1.recv_batch(batch);
+    for (size_t i = 0; i < batch.size(); i++, received++) {
+        if (batch.payload(i) != payloads.at(received)) {
+            throw std::runtime_error("wrong datagram received");
+        }
+    }
+}
@@ -13,6 +13,8 @@ add_test(NAME t_recv_window          COMMAND recv_window)
 add_test(NAME t_recv_reorder         COMMAND recv_reorder)
 add_test(NAME t_recv_close           COMMAND recv_close)
 add_test(NAME t_recv_special         COMMAND recv_special)
+add_test(NAME t_recv_sack            COMMAND recv_sack)
+add_test(NAME t_recv_window_scale    COMMAND recv_window_scale)
 
 add_test(NAME t_send_connect         COMMAND send_connect)
 add_test(NAME t_send_transmit        COMMAND send_transmit)
@@ -21,6 +23,10 @@ add_test(NAME t_send_window          COMMAND send_window)
 add_test(NAME t_send_ack             COMMAND send_ack)
 add_test(NAME t_send_close           COMMAND send_close)
 add_test(NAME t_send_extra           COMMAND send_extra)
+add_test(NAME t_send_fast_retx       COMMAND send_fast_retx)
+add_test(NAME t_send_rto             COMMAND send_rto)
+add_test(NAME t_send_sack            COMMAND send_sack)
+add_test(NAME t_send_bbr             COMMAND send_bbr)
 
 add_test(NAME t_strm_reassem_single      COMMAND fsm_stream_reassembler_single)
 add_test(NAME t_strm_reassem_seq         COMMAND fsm_stream_reassembler_seq)
@@ -36,6 +42,19 @@ add_test(NAME t_byte_stream_one_write    COMMAND byte_stream_one_write)
 add_test(NAME t_byte_stream_two_writes   COMMAND byte_stream_two_writes)
 add_test(NAME t_byte_stream_capacity     COMMAND byte_stream_capacity)
 add_test(NAME t_byte_stream_many_writes  COMMAND byte_stream_many_writes)
+add_test(NAME t_byte_stream_chunked      COMMAND byte_stream_chunked)
+
+add_test(NAME t_checksum_fuzz            COMMAND checksum_fuzz)
+add_test(NAME t_tcp_serialize            COMMAND tcp_serialize)
+add_test(NAME t_packet_buffer            COMMAND packet_buffer)
+add_test(NAME t_small_vector             COMMAND small_vector)
+add_test(NAME t_eventloop                COMMAND eventloop)
+add_test(NAME t_timer_wheel              COMMAND timer_wheel)
+add_test(NAME t_sharded_eventloop        COMMAND sharded_eventloop)
+add_test(NAME t_io_uring                 COMMAND io_uring)
+add_test(NAME t_file_descriptor          COMMAND file_descriptor)
+add_test(NAME t_udp_batch                COMMAND udp_batch)
+add_test(NAME t_tun_multiqueue           COMMAND tun_multiqueue)
 
 add_test(NAME t_webget               COMMAND "${PROJECT_SOURCE_DIR}/tests/webget_t.sh")
 
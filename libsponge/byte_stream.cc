@@ -1,5 +1,7 @@
 #include "byte_stream.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a flow-controlled in-memory byte stream.
 
 // For Lab 0, please replace with a real implementation that passes the
@@ -12,47 +14,170 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-ByteStream::ByteStream(const size_t capacity) : cap{capacity}, bytesread{0}, byteswritten{0}, endin{false} {}
+//! \param[in] capacity is the maximum number of bytes the stream will buffer
+//! \param[in] storage selects between copying bytes into a ring buffer and keeping shared Buffer chunks
+ByteStream::ByteStream(const size_t capacity, const Storage storage)
+    : _storage(storage), _capacity(capacity), _ring(storage == Storage::Ring ? capacity : 0, '\0') {}
+
+size_t ByteStream::write(const string_view data) {
+    _popped.clear();
+    const size_t writebytes = min(remaining_capacity(), data.size());
+    if (writebytes == 0) {
+        return 0;
+    }
+
+    if (_storage == Storage::Chunked) {
+        _chunks.emplace_back(PacketBuffer(data.substr(0, writebytes)));
+    } else {
+        // copy into the free space, which may wrap around the end of the ring
+        const size_t tail = (_head + _size) % _ring.size();
+        const size_t first_part = min(writebytes, _ring.size() - tail);
+        copy_n(data.data(), first_part, _ring.begin() + tail);
+        copy_n(data.data() + first_part, writebytes - first_part, _ring.begin());
+    }
+
+    _size += writebytes;
+    _bytes_written += writebytes;
+    return writebytes;
+}
+
+size_t ByteStream::write(Buffer data) {
+    if (_storage == Storage::Ring) {
+        return write(data.str());
+    }
+
+    _popped.clear();
+    const size_t writebytes = min(remaining_capacity(), data.size());
+    if (writebytes == 0) {
+        return 0;
+    }
 
-size_t ByteStream::write(const string &data) {
-    size_t rmn_cap = this->remaining_capacity();
-    size_t writebytes = rmn_cap < data.size() ? rmn_cap : data.size();
+    data.remove_suffix(data.size() - writebytes);
+    _chunks.push_back(move(data));
 
-    this->bytestream.append(data.substr(0, writebytes));
-    this->byteswritten += writebytes;
+    _size += writebytes;
+    _bytes_written += writebytes;
     return writebytes;
 }
 
+//! \param[in] len bytes will be viewed from the output side of the buffer
+ByteStream::View ByteStream::peek_view(const size_t len) const {
+    const size_t viewbytes = min(len, _size);
+    if (viewbytes == 0) {
+        return {};
+    }
+
+    if (_storage == Storage::Chunked) {
+        const string_view first = _chunks[0].str().substr(0, viewbytes);
+        if (first.size() == viewbytes) {
+            return {first, {}};
+        }
+        return {first, _chunks[1].str().substr(0, viewbytes - first.size())};
+    }
+
+    const string_view ring{_ring};
+    const size_t first_part = min(viewbytes, _ring.size() - _head);
+    return {ring.substr(_head, first_part), ring.substr(0, viewbytes - first_part)};
+}
+
 //! \param[in] len bytes will be copied from the output side of the buffer
-string ByteStream::peek_output(const size_t len) const { return this->bytestream.substr(0, len); }
+string ByteStream::peek_output(const size_t len) const {
+    string ret;
+    ret.reserve(min(len, _size));
+
+    if (_storage == Storage::Chunked) {
+        for (auto it = _chunks.begin(); it != _chunks.end() and ret.size() < len; ++it) {
+            ret.append(it->str().substr(0, len - ret.size()));
+        }
+        return ret;
+    }
+
+    const auto [first, second] = peek_view(len);
+    ret.append(first).append(second);
+    return ret;
+}
+
+//! \param[in] len bytes will be shared (or, in Storage::Ring mode, copied) from the output side of the buffer
+BufferList ByteStream::peek_buffer(const size_t len) const {
+    if (_storage == Storage::Ring) {
+        return peek_output(len);
+    }
+
+    BufferList ret;
+    size_t remaining = min(len, _size);
+    for (auto it = _chunks.begin(); remaining > 0; ++it) {
+        Buffer chunk = *it;
+        if (chunk.size() > remaining) {
+            chunk.remove_suffix(chunk.size() - remaining);
+        }
+        remaining -= chunk.size();
+        ret.append(chunk);
+    }
+    return ret;
+}
 
 //! \param[in] len bytes will be removed from the output side of the buffer
 void ByteStream::pop_output(const size_t len) {
-    this->bytestream.erase(0, len);
-    this->bytesread += len;
+    const size_t popbytes = min(len, _size);
+    _size -= popbytes;
+    _bytes_read += popbytes;
+
+    if (_storage == Storage::Chunked) {
+        // (the chunks popped whole stay alive for the views that read_view() returned)
+        _popped.clear();
+        size_t remaining = popbytes;
+        while (remaining > 0) {
+            if (remaining < _chunks.front().size()) {
+                _chunks.front().remove_prefix(remaining);
+                break;
+            }
+            remaining -= _chunks.front().size();
+            _popped.push_back(move(_chunks.front()));
+            _chunks.pop_front();
+        }
+        return;
+    }
+
+    _head = _size == 0 ? 0 : (_head + popbytes) % _ring.size();
 }
 
 //! Read (i.e., copy and then pop) the next "len" bytes of the stream
 //! \param[in] len bytes will be popped and returned
 //! \returns a string
 std::string ByteStream::read(const size_t len) {
-    std::string ans = this->bytestream.substr(0, len);
+    std::string ans = peek_output(len);
+    pop_output(len);
+    return ans;
+}
+
+//! \param[in] len bytes (at most) will be popped and returned as views
+//! \details The popped bytes stay in place until a later write() reuses their space (or, in
+//! Storage::Chunked mode, until the next write() or pop_output() lets go of their chunks).
+ByteStream::View ByteStream::read_view(const size_t len) {
+    const View ans = peek_view(len);
+    pop_output(ans.first.size() + ans.second.size());
+    return ans;
+}
+
+//! \param[in] len bytes will be popped and returned as Buffers
+BufferList ByteStream::read_buffer(const size_t len) {
+    BufferList ans = peek_buffer(len);
     pop_output(len);
     return ans;
 }
 
-void ByteStream::end_input() { this->endin = true; }
+void ByteStream::end_input() { _input_ended = true; }
 
-bool ByteStream::input_ended() const { return this->endin; }
+bool ByteStream::input_ended() const { return _input_ended; }
 
-size_t ByteStream::buffer_size() const { return this->bytestream.size(); }
+size_t ByteStream::buffer_size() const { return _size; }
 
-bool ByteStream::buffer_empty() const { return this->bytestream.empty(); }
+bool ByteStream::buffer_empty() const { return _size == 0; }
 
 bool ByteStream::eof() const { return input_ended() && buffer_empty(); }
 
-size_t ByteStream::bytes_written() const { return this->byteswritten; }
+size_t ByteStream::bytes_written() const { return _bytes_written; }
 
-size_t ByteStream::bytes_read() const { return this->bytesread; }
+size_t ByteStream::bytes_read() const { return _bytes_read; }
 
-size_t ByteStream::remaining_capacity() const { return this->cap - this->bytestream.size(); }
+size_t ByteStream::remaining_capacity() const { return _capacity - _size; }
@@ -1,7 +1,12 @@
 #ifndef SPONGE_LIBSPONGE_BYTE_STREAM_HH
 #define SPONGE_LIBSPONGE_BYTE_STREAM_HH
 
+#include "buffer.hh"
+
+#include <deque>
 #include <string>
+#include <string_view>
+#include <utility>
 
 //! \brief An in-order byte stream.
 
@@ -9,25 +14,35 @@
 //! side.  The byte stream is finite: the writer can end the input,
 //! and then no more bytes can be written.
 class ByteStream {
-  private:
-    // Your code here -- add private members as necessary.
+  public:
+    //! \brief The buffered bytes at the front of the stream, as (at most) two contiguous pieces
+    //! \details The second view is non-empty only when the requested bytes wrap around
+    //! the end of the stream's circular storage.
+    using View = std::pair<std::string_view, std::string_view>;
 
-    // Hint: This doesn't need to be a sophisticated data structure at
-    // all, but if any of your tests are taking longer than a second,
-    // that's a sign that you probably want to keep exploring
-    // different approaches.
+    //! How the stream keeps the bytes that have been written but not yet read
+    enum class Storage {
+        Ring,    //!< Copy the bytes into a circular buffer allocated at construction
+        Chunked  //!< Keep a queue of shared Buffer chunks, so written Buffers are never copied
+    };
 
-    std::string bytestream{};
-    size_t cap{};
-    size_t bytesread{};
-    size_t byteswritten{};
-    bool endin{};
+  private:
+    Storage _storage;              //!< The storage mode chosen at construction
+    size_t _capacity;              //!< Maximum number of buffered bytes
+    std::string _ring{};           //!< Circular storage with room for exactly `capacity` bytes (Storage::Ring)
+    std::deque<Buffer> _chunks{};  //!< Buffered chunks, in stream order (Storage::Chunked)
+    std::deque<Buffer> _popped{};  //!< Chunks popped by the last pop, kept until the next write or pop
+    size_t _head{};                //!< Index in `_ring` of the next byte to be read
+    size_t _size{};                //!< Number of bytes currently buffered
+    size_t _bytes_read{};          //!< Total number of bytes popped
+    size_t _bytes_written{};       //!< Total number of bytes accepted
+    bool _input_ended{};           //!< Flag indicating that the writer has ended the input
 
     bool _error{};  //!< Flag indicating that the stream suffered an error.
 
   public:
     //! Construct a stream with room for `capacity` bytes.
-    ByteStream(const size_t capacity);
+    ByteStream(const size_t capacity, const Storage storage = Storage::Ring);
 
     //! \name "Input" interface for the writer
     //!@{
@@ -35,7 +50,17 @@ class ByteStream {
     //! Write a string of bytes into the stream. Write as many
     //! as will fit, and return how many were written.
     //! \returns the number of bytes accepted into the stream
-    size_t write(const std::string &data);
+    size_t write(const std::string &data) { return write(std::string_view(data)); }
+
+    //! Write a string of bytes into the stream. Write as many
+    //! as will fit, and return how many were written.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(const std::string_view data);
+
+    //! Write a Buffer into the stream. Write as many bytes as will fit, and return how many were written.
+    //! \note In Storage::Chunked mode, the stream shares the Buffer's storage instead of copying it.
+    //! \returns the number of bytes accepted into the stream
+    size_t write(Buffer data);
 
     //! \returns the number of additional bytes that the stream has space for
     size_t remaining_capacity() const;
@@ -54,6 +79,14 @@ class ByteStream {
     //! \returns a string
     std::string peek_output(const size_t len) const;
 
+    //! Peek at next "len" bytes of the stream without copying them
+    //! \returns views into the stream's storage, valid until the next write
+    View peek_view(const size_t len) const;
+
+    //! Peek at next "len" bytes of the stream as a list of Buffers
+    //! \returns Buffers that share storage with the stream (in Storage::Chunked mode)
+    BufferList peek_buffer(const size_t len) const;
+
     //! Remove bytes from the buffer
     void pop_output(const size_t len);
 
@@ -61,6 +94,16 @@ class ByteStream {
     //! \returns a string
     std::string read(const size_t len);
 
+    //! Read (i.e., pop without copying) the next "len" bytes of the stream
+    //! \details Only the bytes returned are popped: in Storage::Chunked mode, that may be fewer than `len`
+    //! (see peek_view()), so call it again for the rest.
+    //! \returns views into the stream's storage, valid until the next write or pop
+    View read_view(const size_t len);
+
+    //! Read (i.e., share and then pop) the next "len" bytes of the stream as a list of Buffers
+    //! \returns Buffers that share storage with what the writer wrote (in Storage::Chunked mode)
+    BufferList read_buffer(const size_t len);
+
     //! \returns `true` if the stream input has ended
     bool input_ended() const;
 
@@ -88,4 +131,19 @@ class ByteStream {
     //!@}
 };
 
+//! \class ByteStream
+//! The bytes are kept in a fixed-size circular buffer that is allocated once, at construction.
+//! Popping bytes only advances the read position, so draining a full stream costs time linear
+//! in the number of bytes, no matter how small the individual pops are.
+//!
+//! Readers that don't need their own copy of the data can use peek_view() or read_view(), which
+//! return (at most) two `std::string_view`s into the circular buffer instead of building a new
+//! std::string.
+//!
+//! A stream constructed with Storage::Chunked instead keeps the Buffers passed to write(Buffer)
+//! as they are, e.g. the payloads of received TCP segments. Nothing is copied until the reader
+//! asks for a std::string, and peek_buffer() or read_buffer() hand the chunks on without copying
+//! at all. In this mode peek_view() and read_view() only cover the first two chunks, so they may
+//! return (and read_view() may pop) fewer than `len` bytes.
+
 #endif  // SPONGE_LIBSPONGE_BYTE_STREAM_HH
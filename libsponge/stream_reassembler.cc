@@ -1,5 +1,7 @@
 #include "stream_reassembler.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a stream reassembler.
 
 // For Lab 1, please replace with a real implementation that passes the
@@ -12,64 +14,53 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
-StreamReassembler::StreamReassembler(const size_t capacity) : _output(capacity), _capacity{capacity} {}
-
-void StreamReassembler::discard_substrings() {
-    // discard the part exceeding the capacity
-    size_t rmn_cap = _output.remaining_capacity(), uabd_bytes = unassembled_bytes();
-    while (uabd_bytes > rmn_cap) {
-        auto iter = _substrings.rbegin();
-        if (uabd_bytes - rmn_cap >= iter->data.size()) {
-            // directly discard the whole piece
-            _substrings.pop_back();
-            uabd_bytes -= iter->data.size();
-        } else {
-            // discard part of the piece
-            iter->data.erase(iter->data.begin() + uabd_bytes - rmn_cap);
-            uabd_bytes = rmn_cap;
-            break;
+StreamReassembler::StreamReassembler(const size_t capacity)
+    : _output(capacity, ByteStream::Storage::Chunked), _capacity{capacity} {}
+
+void StreamReassembler::store_substring(Buffer data, uint64_t index) {
+    uint64_t index_end = index + data.size();
+
+    // trim the front against the substring stored at or before `index`
+    auto iter = _unassembled.upper_bound(index);
+    if (iter != _unassembled.begin()) {
+        const auto &[prev_index, prev_data] = *prev(iter);
+        const uint64_t prev_end = prev_index + prev_data.size();
+        if (prev_end >= index_end)
+            return;
+        if (prev_end > index) {
+            data.remove_prefix(prev_end - index);
+            index = prev_end;
         };
     };
-}
 
-void StreamReassembler::merge_substrings() {
-    auto iter_prev = _substrings.begin(), iter_next = iter_prev;
-    if (iter_next != _substrings.end())
-        ++iter_next;
-
-    while (iter_next != _substrings.end()) {
-        uint64_t prev_end = iter_prev->index + iter_prev->data.size();
-        uint64_t next_begin = iter_next->index, next_end = iter_next->index + iter_next->data.size();
-        // prev_begin <= next_begin < next_end <= prev_end
-        if (next_end <= prev_end)
-            iter_next = _substrings.erase(iter_next);
-        else if (next_begin <= prev_end) {
-            // prev_begin <= next_begin <= prev_end < next_end
-            iter_prev->data.append(iter_next->data.substr(prev_end - next_begin));
-            iter_next = _substrings.erase(iter_next);
-        } else {
-            // not overlap
-            iter_prev++;
-            iter_next++;
+    // drop the stored substrings that this one covers, and trim the back against the first one it doesn't
+    while (iter != _unassembled.end() && iter->first < index_end) {
+        const uint64_t next_end = iter->first + iter->second.size();
+        if (next_end > index_end) {
+            data.remove_suffix(index_end - iter->first);
+            index_end = iter->first;
+            break;
         };
+        _unassembled_bytes -= iter->second.size();
+        iter = _unassembled.erase(iter);
     };
-    return;
+
+    _unassembled_bytes += data.size();
+    _unassembled.emplace_hint(iter, index, move(data));
 }
 
-void StreamReassembler::write_substrings() {
-    while (!_substrings.empty()) {
-        auto iter = _substrings.begin();
-        size_t idx_begin = iter->index, idx_end = iter->index + iter->data.size();
-        if (_nextbyte >= idx_end)
-            _substrings.erase(iter);
-        else if (_nextbyte < idx_begin)
+void StreamReassembler::write_stored_substrings() {
+    while (!_unassembled.empty()) {
+        auto iter = _unassembled.begin();
+        const uint64_t idx_begin = iter->first, idx_end = iter->first + iter->second.size();
+        if (_nextbyte < idx_begin)
             break;
-        else {
-            // just regard the piece as a incoming part and reuse the function to handle it
-            const size_t writebytes = _output.write(iter->data.substr(_nextbyte - idx_begin));
-            _nextbyte += writebytes;
-            _substrings.erase(iter);
+        _unassembled_bytes -= iter->second.size();
+        if (_nextbyte < idx_end) {
+            iter->second.remove_prefix(_nextbyte - idx_begin);
+            _nextbyte += _output.write(move(iter->second));
         };
+        _unassembled.erase(iter);
     };
 }
 
@@ -77,47 +68,49 @@ void StreamReassembler::write_substrings() {
 //! possibly out-of-order, from the logical stream, and assembles any newly
 //! contiguous substrings and writes them into the output stream in order.
 void StreamReassembler::push_substring(const string &data, const size_t index, const bool eof) {
-    size_t index_begin = index, index_end = index + data.size();
+    push_substring(Buffer(PacketBuffer(data)), index, eof);
+}
+
+//! \details Same as push_substring(const string &, ...), but the bytes that are kept
+//! share storage with `data` instead of being copied.
+void StreamReassembler::push_substring(const Buffer &data, const size_t index, const bool eof) {
     if (eof) {
         _eof = true;
-        _end_index = index_end;
+        _end_index = index + data.size();
     };
 
-    // already have read it or store it in the ByteStream
-    // simply discard it
-    if (_nextbyte >= index_end) {
-    } else if (index_begin <= _nextbyte && _nextbyte < index_end) {
-        // directly write it into the ByteStream as much as we can
-        const size_t writebytes = _output.write(data.substr(_nextbyte - index_begin));
-        _nextbyte += writebytes;
-
-        write_substrings();
-    } else if (_nextbyte < index_begin) {
-        // insert and combine the part into the _substrings, find the correct position to insert
-        auto iter = _substrings.begin();
-        while (iter != _substrings.end()) {
-            if (iter->index >= index_begin)
-                break;
-            else
-                iter++;
-        };
-
-        _substrings.insert(iter, substring(data, index, eof));
+    // only the bytes in [_nextbyte, first unacceptable index) can be kept, the rest are discarded
+    const uint64_t window_end = _nextbyte + _output.remaining_capacity();
+    const uint64_t index_begin = max<uint64_t>(index, _nextbyte);
+    const uint64_t index_end = min<uint64_t>(index + data.size(), window_end);
+
+    if (index_begin < index_end) {
+        Buffer piece = data;
+        piece.remove_suffix(index + data.size() - index_end);
+        piece.remove_prefix(index_begin - index);
+        if (index_begin == _nextbyte) {
+            // directly write it into the ByteStream, then whatever has become contiguous with it
+            _nextbyte += _output.write(move(piece));
+            write_stored_substrings();
+        } else
+            store_substring(move(piece), index_begin);
     };
 
-    merge_substrings();
-    discard_substrings();
     if (empty())
         _output.end_input();
-    return;
 }
 
-size_t StreamReassembler::unassembled_bytes() const {
-    // the substring in vector must not overlap
-    size_t cnt = 0;
-    for (const substring sub : _substrings)
-        cnt += sub.data.size();
-    return cnt;
+size_t StreamReassembler::unassembled_bytes() const { return _unassembled_bytes; }
+
+vector<pair<uint64_t, uint64_t>> StreamReassembler::held_ranges() const {
+    vector<pair<uint64_t, uint64_t>> ranges;
+    for (const auto &[index, data] : _unassembled) {
+        if (!ranges.empty() && ranges.back().second == index)
+            ranges.back().second += data.size();
+        else
+            ranges.emplace_back(index, index + data.size());
+    };
+    return ranges;
 }
 
 bool StreamReassembler::empty() const { return _eof && _nextbyte >= _end_index; }
@@ -5,7 +5,9 @@
 
 #include <cstdint>
 #include <iostream>
+#include <map>
 #include <string>
+#include <utility>
 #include <vector>
 
 //! \brief A class that assembles a series of excerpts from a byte stream (possibly out of order,
@@ -20,19 +22,17 @@ class StreamReassembler {
     bool _eof{};            // whether the end of file
     uint64_t _end_index{};  // the end index
 
-    struct substring {
-        // index_begin <= data index in the stream < index_end
-        std::string data{};
-        uint64_t index{};
-        bool eof{};
-        substring(){};
-        substring(const std::string &d, uint64_t i, bool e) : data{d}, index{i}, eof{e} {};
-    };
-    std::vector<substring> _substrings{};
+    //! Stored substrings that can't be written yet, keyed by the stream index of their first byte.
+    //! \note The substrings never overlap, and all of them begin after `_nextbyte`.
+    //! Each one shares storage with the segment payload it came from.
+    std::map<uint64_t, Buffer> _unassembled{};
+    size_t _unassembled_bytes{};  //!< Total size of the substrings in `_unassembled`
 
-    void discard_substrings();  // discard substring exceed the memory limit
-    void merge_substrings();    // merge substring if they are overlapped
-    void write_substrings();    // write substring into _output as much as we can
+    //! Store a substring that begins after `_nextbyte`, trimming away the bytes that are already stored
+    void store_substring(Buffer data, uint64_t index);
+
+    //! Write stored substrings into _output for as long as they are contiguous with it
+    void write_stored_substrings();
 
   public:
     //! \brief Construct a `StreamReassembler` that will store up to `capacity` bytes.
@@ -50,6 +50,15 @@ class StreamReassembler {
     //! \param eof the last byte of `data` will be the last byte in the entire stream
     void push_substring(const std::string &data, const uint64_t index, const bool eof);
 
+    //! \brief Receive a substring held in a Buffer, without copying it
+    //!
+    //! The kept bytes are stored (and handed to the output stream) as slices of `data`.
+    //!
+    //! \param data the substring
+    //! \param index indicates the index (place in sequence) of the first byte in `data`
+    //! \param eof the last byte of `data` will be the last byte in the entire stream
+    void push_substring(const Buffer &data, const uint64_t index, const bool eof);
+
     //! \name Access the reassembled byte stream
     //!@{
     const ByteStream &stream_out() const { return _output; }
@@ -62,6 +71,10 @@ class StreamReassembler {
     //! should only be counted once for the purpose of this function.
     size_t unassembled_bytes() const;
 
+    //! \brief The stream indices held but not yet reassembled, as [first, last + 1) ranges in index order
+    //! \note Stored substrings that touch are merged into one range, so the ranges never touch or overlap.
+    std::vector<std::pair<uint64_t, uint64_t>> held_ranges() const;
+
     //! \brief Is the internal state empty (other than the output stream)?
     //! \returns `true` if no substrings are waiting to be assembled
     bool empty() const;
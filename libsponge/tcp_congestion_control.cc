@@ -0,0 +1,293 @@
+#include "tcp_congestion_control.hh"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+
+using namespace std;
+
+//! \returns the initial congestion window of RFC 6928, in bytes
+static size_t initial_window(const size_t mss) { return min(10 * mss, max(2 * mss, size_t{14600})); }
+
+//! \returns the window after a partial ACK of `acked_bytes` during fast recovery (RFC 6582): shrink it by the
+//! amount acknowledged, as those bytes left the network, then add back a segment for the retransmission
+static size_t deflate_after_partial_ack(const size_t cwnd, const size_t acked_bytes, const size_t mss) {
+    return cwnd - min(cwnd, acked_bytes) + (acked_bytes >= mss ? mss : 0);
+}
+
+//! \returns the window after a duplicate ACK during fast recovery (RFC 5681): one segment larger, but never
+//! more than one segment beyond what is in flight, so a window that can't be used doesn't keep inflating
+static size_t inflate_after_duplicate_ack(const size_t cwnd, const size_t bytes_in_flight, const size_t mss) {
+    return max(cwnd, min(cwnd + mss, bytes_in_flight + mss));
+}
+
+//! \returns the window at the end of fast recovery (RFC 6582), which must not allow a burst of new segments
+static size_t window_after_recovery(const size_t ssthresh, const size_t bytes_in_flight, const size_t mss) {
+    return min(ssthresh, max(bytes_in_flight, mss) + mss);
+}
+
+unique_ptr<CongestionController> make_congestion_controller(const TCPConfig::CongestionControl algorithm,
+                                                            const size_t mss) {
+    switch (algorithm) {
+        case TCPConfig::CongestionControl::None:
+            return nullptr;
+        case TCPConfig::CongestionControl::Reno:
+            return make_unique<RenoCongestionController>(mss);
+        case TCPConfig::CongestionControl::Cubic:
+            return make_unique<CubicCongestionController>(mss);
+        case TCPConfig::CongestionControl::BBR:
+            return make_unique<BBRCongestionController>(mss);
+    }
+    return nullptr;
+}
+
+// Reno
+
+RenoCongestionController::RenoCongestionController(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+size_t RenoCongestionController::ssthresh_after_loss(const size_t bytes_in_flight) const {
+    return max(bytes_in_flight / 2, 2 * _mss);
+}
+
+//! \returns whether the window was (nearly) full before this ACK; if the receiver's window or the application
+//! held the sender back, the ACK says nothing about whether a larger window would have worked (RFC 7661)
+static bool window_was_full(const CongestionAck &ack, const size_t cwnd, const size_t mss) {
+    return ack.bytes_in_flight + ack.acked_bytes + mss > cwnd;
+}
+
+void RenoCongestionController::on_ack(const CongestionAck &ack) {
+    if (ack.in_recovery) {
+        _cwnd = deflate_after_partial_ack(_cwnd, ack.acked_bytes, _mss);
+        return;
+    }
+    if (not window_was_full(ack, _cwnd, _mss)) {
+        return;
+    }
+
+    // slow start: grow by (at most) one segment per ACK, doubling the window every round trip
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(ack.acked_bytes, _mss);
+        return;
+    }
+
+    // congestion avoidance: grow by one segment per window's worth of acknowledged bytes
+    _bytes_acked += ack.acked_bytes;
+    if (_bytes_acked >= _cwnd) {
+        _bytes_acked -= _cwnd;
+        _cwnd += _mss;
+    }
+}
+
+void RenoCongestionController::on_timeout(const size_t bytes_in_flight, const uint64_t /* now_ms */) {
+    _ssthresh = ssthresh_after_loss(bytes_in_flight);
+    _cwnd = _mss;
+    _bytes_acked = 0;
+}
+
+void RenoCongestionController::on_fast_retransmit(const size_t bytes_in_flight, const uint64_t /* now_ms */) {
+    // halve the window, then inflate it by the three segments that the duplicate ACKs say have left the network
+    _ssthresh = ssthresh_after_loss(bytes_in_flight);
+    _cwnd = _ssthresh + 3 * _mss;
+    _bytes_acked = 0;
+}
+
+void RenoCongestionController::on_duplicate_ack(const size_t bytes_in_flight) {
+    _cwnd = inflate_after_duplicate_ack(_cwnd, bytes_in_flight, _mss);
+}
+
+void RenoCongestionController::on_recovery_end(const size_t bytes_in_flight) {
+    _cwnd = window_after_recovery(_ssthresh, bytes_in_flight, _mss);
+}
+
+// CUBIC
+
+CubicCongestionController::CubicCongestionController(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+void CubicCongestionController::reduce() {
+    const double cwnd_segments = static_cast<double>(_cwnd) / _mss;
+    // fast convergence: if the window shrank since the last loss, release some bandwidth to newer flows
+    _w_max = cwnd_segments < _w_max ? cwnd_segments * (1 + BETA) / 2 : cwnd_segments;
+    _ssthresh = max(static_cast<size_t>(_cwnd * BETA), 2 * _mss);
+    _epoch_start.reset();
+}
+
+void CubicCongestionController::on_ack(const CongestionAck &ack) {
+    if (ack.rtt_ms.has_value()) {
+        _min_rtt_ms = min(_min_rtt_ms, max(*ack.rtt_ms, uint64_t{1}));
+    }
+
+    if (ack.in_recovery) {
+        _cwnd = deflate_after_partial_ack(_cwnd, ack.acked_bytes, _mss);
+        return;
+    }
+    if (not window_was_full(ack, _cwnd, _mss)) {
+        // the cubic function measures time spent growing, so don't let it run while the window can't grow
+        _epoch_start.reset();
+        return;
+    }
+
+    if (_cwnd < _ssthresh) {
+        _cwnd += min(ack.acked_bytes, _mss);
+        return;
+    }
+
+    const double cwnd_segments = static_cast<double>(_cwnd) / _mss;
+    if (not _epoch_start.has_value()) {
+        _epoch_start = ack.now_ms;
+        _w_max = max(_w_max, cwnd_segments);
+        _k = cbrt((_w_max - cwnd_segments) / C);
+        _w_est = cwnd_segments;
+    }
+
+    // aim for where the cubic function will be one round trip from now, but grow by at most 50% per round trip
+    const double rtt_s = (_min_rtt_ms == numeric_limits<uint64_t>::max() ? 100 : _min_rtt_ms) / 1000.0;
+    const double t = (ack.now_ms - *_epoch_start) / 1000.0;
+    const double w_cubic = C * pow(t + rtt_s - _k, 3) + _w_max;
+    const double target = min(max(w_cubic, cwnd_segments), 1.5 * cwnd_segments);
+    double increase = (target - cwnd_segments) / cwnd_segments * ack.acked_bytes;
+
+    // never grow more slowly than Reno would in the same conditions
+    _w_est += 3 * (1 - BETA) / (1 + BETA) * ack.acked_bytes / _cwnd;
+    if (_w_est > cwnd_segments) {
+        increase = max(increase, (_w_est - cwnd_segments) * _mss);
+    }
+    _cwnd += static_cast<size_t>(increase);
+}
+
+void CubicCongestionController::on_timeout(const size_t /* bytes_in_flight */, const uint64_t /* now_ms */) {
+    reduce();
+    _cwnd = _mss;
+}
+
+void CubicCongestionController::on_fast_retransmit(const size_t /* bytes_in_flight */, const uint64_t /* now_ms */) {
+    reduce();
+    _cwnd = _ssthresh + 3 * _mss;
+}
+
+void CubicCongestionController::on_duplicate_ack(const size_t bytes_in_flight) {
+    _cwnd = inflate_after_duplicate_ack(_cwnd, bytes_in_flight, _mss);
+}
+
+void CubicCongestionController::on_recovery_end(const size_t bytes_in_flight) {
+    _cwnd = window_after_recovery(_ssthresh, bytes_in_flight, _mss);
+}
+
+// BBR
+
+//! Window gains of the ProbeBandwidth phase, one per round trip: probe for more bandwidth,
+//! drain the queue that probing built, then cruise
+static constexpr array<double, 8> PROBE_BANDWIDTH_GAINS{1.25, 0.75, 1, 1, 1, 1, 1, 1};
+
+BBRCongestionController::BBRCongestionController(const size_t mss) : _mss(mss), _cwnd(initial_window(mss)) {}
+
+double BBRCongestionController::bottleneck_bandwidth() const {
+    double ret = 0;
+    for (const auto &sample : _bandwidth_samples) {
+        ret = max(ret, sample.second);
+    }
+    return ret;
+}
+
+double BBRCongestionController::bdp() const { return bottleneck_bandwidth() * _min_rtt_ms; }
+
+void BBRCongestionController::end_round(const uint64_t now_ms) {
+    const double delivery_rate = static_cast<double>(_round_delivered) / max(now_ms - _round_start_ms, uint64_t{1});
+    ++_round;
+    _round_start_ms = now_ms;
+    _round_delivered = 0;
+
+    _bandwidth_samples.emplace_back(_round, delivery_rate);
+    while (_bandwidth_samples.front().first + BANDWIDTH_ROUNDS <= _round) {
+        _bandwidth_samples.pop_front();
+    }
+
+    if (_mode == Mode::Startup) {
+        // the pipe is full once three rounds in a row failed to raise the bandwidth by 25%
+        if (bottleneck_bandwidth() >= 1.25 * _full_bandwidth) {
+            _full_bandwidth = bottleneck_bandwidth();
+            _full_bandwidth_rounds = 0;
+        } else if (++_full_bandwidth_rounds >= 3) {
+            _mode = Mode::Drain;
+        }
+    } else if (_mode == Mode::ProbeBandwidth) {
+        _cycle_index = (_cycle_index + 1) % PROBE_BANDWIDTH_GAINS.size();
+    }
+}
+
+void BBRCongestionController::on_ack(const CongestionAck &ack) {
+    // (checked before a new sample can refresh the filter, so that steady samples don't keep ProbeRTT away)
+    const bool min_rtt_expired =
+        _min_rtt_ms != numeric_limits<uint64_t>::max() and ack.now_ms - _min_rtt_stamp > MIN_RTT_WINDOW_MS;
+    if (ack.rtt_ms.has_value()) {
+        const uint64_t rtt = max(*ack.rtt_ms, uint64_t{1});
+        if (rtt < _min_rtt_ms or min_rtt_expired) {
+            _min_rtt_ms = rtt;
+            _min_rtt_stamp = ack.now_ms;
+        }
+    }
+
+    // until there is a round-trip time, there is no model to size the window from
+    if (_min_rtt_ms == numeric_limits<uint64_t>::max()) {
+        _cwnd += ack.acked_bytes;
+        return;
+    }
+
+    _round_delivered += ack.acked_bytes;
+    if (ack.now_ms - _round_start_ms >= _min_rtt_ms) {
+        end_round(ack.now_ms);
+    }
+
+    if (_mode == Mode::Drain and ack.bytes_in_flight <= bdp()) {
+        // start cruising, so that the queue drained here isn't refilled by probing right away
+        _mode = Mode::ProbeBandwidth;
+        _cycle_index = 2;
+    }
+
+    // every so often, shrink the window so the queue empties and the true minimum RTT becomes visible
+    if (_mode != Mode::ProbeRTT and min_rtt_expired) {
+        _mode = Mode::ProbeRTT;
+        _probe_rtt_done_ms = ack.now_ms + PROBE_RTT_MS + _min_rtt_ms;
+    }
+    if (_mode == Mode::ProbeRTT and ack.now_ms >= _probe_rtt_done_ms) {
+        _min_rtt_stamp = ack.now_ms;
+        _mode = _full_bandwidth_rounds >= 3 ? Mode::ProbeBandwidth : Mode::Startup;
+    }
+
+    const size_t min_cwnd = 4 * _mss;
+    switch (_mode) {
+        case Mode::Startup:
+            // slow start, up to HIGH_GAIN times the model's bandwidth-delay product
+            if (_bandwidth_samples.empty() or _cwnd < HIGH_GAIN * bdp()) {
+                _cwnd += ack.acked_bytes;
+            }
+            break;
+        case Mode::Drain:
+            _cwnd = max(static_cast<size_t>(bdp()), min_cwnd);
+            break;
+        case Mode::ProbeBandwidth:
+            _cwnd = max(static_cast<size_t>(PROBE_BANDWIDTH_GAINS[_cycle_index] * bdp()), min_cwnd);
+            break;
+        case Mode::ProbeRTT:
+            _cwnd = min_cwnd;
+            break;
+    }
+}
+
+//! \details BBR doesn't treat loss as a congestion signal, but a timeout means the model is stale:
+//! send one segment, and let the next acknowledgment size the window again. A timeout during
+//! startup also means the pipe (and the queue in front of it) is already full.
+void BBRCongestionController::on_timeout(const size_t /* bytes_in_flight */, const uint64_t /* now_ms */) {
+    if (_mode == Mode::Startup) {
+        _mode = Mode::Drain;
+        _full_bandwidth_rounds = 3;
+    }
+    _cwnd = _mss;
+}
+
+//! \details Loss doesn't change BBR's model, but loss during startup means the pipe is full.
+void BBRCongestionController::on_fast_retransmit(const size_t /* bytes_in_flight */, const uint64_t /* now_ms */) {
+    if (_mode == Mode::Startup) {
+        _mode = Mode::Drain;
+        _full_bandwidth_rounds = 3;
+    }
+}
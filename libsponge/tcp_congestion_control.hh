@@ -0,0 +1,165 @@
+#ifndef SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
+#define SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
+
+#include "tcp_config.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+
+//! \brief What the TCPSender learned from an acknowledgment that advanced its ackno
+struct CongestionAck {
+    size_t acked_bytes;              //!< Number of sequence numbers newly acknowledged
+    size_t bytes_in_flight;          //!< Sequence numbers still in flight after this acknowledgment
+    uint64_t now_ms;                 //!< Time of the acknowledgment, in milliseconds since the sender started
+    std::optional<uint64_t> rtt_ms;  //!< Round-trip time of a segment that this ACK covered, if it was measurable
+    bool in_recovery;                //!< Whether this is a partial ACK during fast recovery (RFC 6582)
+};
+
+//! \brief Interface for the congestion-control algorithm of a TCPSender
+//! \details The TCPSender never has more than min(window(), receiver's window) sequence numbers
+//! in flight, and tells the controller about acknowledgments and losses.
+class CongestionController {
+  public:
+    //! \returns the congestion window, in bytes
+    virtual size_t window() const = 0;
+
+    //! \brief The peer acknowledged new data
+    virtual void on_ack(const CongestionAck &ack) = 0;
+
+    //! \brief The retransmission timer expired with `bytes_in_flight` outstanding
+    virtual void on_timeout(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! \brief Duplicate ACKs triggered a fast retransmit with `bytes_in_flight` outstanding; fast recovery begins
+    virtual void on_fast_retransmit(const size_t bytes_in_flight, const uint64_t now_ms) = 0;
+
+    //! \brief Another duplicate ACK arrived during fast recovery, so one more segment has left the network
+    virtual void on_duplicate_ack(const size_t /* bytes_in_flight */) {}
+
+    //! \brief An ACK covered everything that was outstanding when fast recovery began
+    virtual void on_recovery_end(const size_t /* bytes_in_flight */) {}
+
+    //! \returns the name of the algorithm
+    virtual std::string name() const = 0;
+
+    virtual ~CongestionController() = default;
+};
+
+//! \brief Create the congestion controller chosen in a TCPConfig
+//! \returns a null pointer for TCPConfig::CongestionControl::None (no congestion window)
+std::unique_ptr<CongestionController> make_congestion_controller(const TCPConfig::CongestionControl algorithm,
+                                                                 const size_t mss = TCPConfig::MAX_PAYLOAD_SIZE);
+
+//! \brief Reno (RFC 5681): slow start, then additive increase and multiplicative decrease,
+//! with NewReno (RFC 6582) fast recovery
+class RenoCongestionController : public CongestionController {
+  private:
+    size_t _mss;                                           //!< Maximum segment size, in bytes
+    size_t _cwnd;                                          //!< Congestion window, in bytes
+    size_t _ssthresh{std::numeric_limits<size_t>::max()};  //!< Slow-start threshold, in bytes
+    size_t _bytes_acked{};  //!< Bytes acknowledged in congestion avoidance since the window last grew
+
+    //! \returns the slow-start threshold after a loss with `bytes_in_flight` outstanding
+    size_t ssthresh_after_loss(const size_t bytes_in_flight) const;
+
+  public:
+    explicit RenoCongestionController(const size_t mss);
+
+    size_t window() const override { return _cwnd; }
+    void on_ack(const CongestionAck &ack) override;
+    void on_timeout(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_fast_retransmit(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_duplicate_ack(const size_t bytes_in_flight) override;
+    void on_recovery_end(const size_t bytes_in_flight) override;
+    std::string name() const override { return "Reno"; }
+};
+
+//! \brief CUBIC (RFC 8312): after a loss, the window grows along a cubic function
+//! of the time since the loss, centered on the window size where the loss happened
+class CubicCongestionController : public CongestionController {
+  private:
+    static constexpr double C = 0.4;     //!< Scaling constant of the cubic function
+    static constexpr double BETA = 0.7;  //!< Multiplicative decrease factor
+
+    size_t _mss;                                                 //!< Maximum segment size, in bytes
+    size_t _cwnd;                                                //!< Congestion window, in bytes
+    size_t _ssthresh{std::numeric_limits<size_t>::max()};        //!< Slow-start threshold, in bytes
+    double _w_max{};                                             //!< Window before the last reduction, in segments
+    double _k{};                                                 //!< Seconds for the cubic to grow back to `_w_max`
+    double _w_est{};                                             //!< Window that Reno would have, in segments
+    std::optional<uint64_t> _epoch_start{};                      //!< When congestion avoidance started, in ms
+    uint64_t _min_rtt_ms{std::numeric_limits<uint64_t>::max()};  //!< Smallest round-trip time seen so far
+
+    //! Remember the window at a loss and lower the slow-start threshold multiplicatively
+    void reduce();
+
+  public:
+    explicit CubicCongestionController(const size_t mss);
+
+    size_t window() const override { return _cwnd; }
+    void on_ack(const CongestionAck &ack) override;
+    void on_timeout(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_fast_retransmit(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_duplicate_ack(const size_t bytes_in_flight) override;
+    void on_recovery_end(const size_t bytes_in_flight) override;
+    std::string name() const override { return "CUBIC"; }
+};
+
+//! \brief A simplified [BBR](https://queue.acm.org/detail.cfm?id=3022184): sizes the window from
+//! the measured bottleneck bandwidth and minimum round-trip time instead of reacting to loss
+//! \details Sponge has no packet pacing, so the pacing gains of BBR are applied to the congestion window.
+class BBRCongestionController : public CongestionController {
+  public:
+    //! The phases of the BBR state machine
+    enum class Mode { Startup, Drain, ProbeBandwidth, ProbeRTT };
+
+  private:
+    static constexpr double HIGH_GAIN = 2.885;             //!< 2/ln(2): cap on the Startup window, times the BDP
+    static constexpr size_t BANDWIDTH_ROUNDS = 10;         //!< Rounds remembered by the bandwidth max-filter
+    static constexpr uint64_t MIN_RTT_WINDOW_MS = 10'000;  //!< Lifetime of a min-RTT measurement
+    static constexpr uint64_t PROBE_RTT_MS = 200;          //!< Time spent with a minimal window in ProbeRTT
+
+    size_t _mss;                //!< Maximum segment size, in bytes
+    size_t _cwnd;               //!< Congestion window, in bytes
+    Mode _mode{Mode::Startup};  //!< Current phase of the state machine
+
+    std::deque<std::pair<uint64_t, double>> _bandwidth_samples{};  //!< (round, bytes per ms) of recent rounds
+    uint64_t _min_rtt_ms{std::numeric_limits<uint64_t>::max()};    //!< Minimum round-trip time in the window
+    uint64_t _min_rtt_stamp{};                                     //!< When `_min_rtt_ms` was measured
+
+    uint64_t _round{};                  //!< Number of round trips so far
+    uint64_t _round_start_ms{};         //!< Time the current round started
+    size_t _round_delivered{};          //!< Bytes acknowledged in the current round
+    double _full_bandwidth{};           //!< Bandwidth that startup last grew by 25%
+    unsigned _full_bandwidth_rounds{};  //!< Rounds of startup without 25% growth
+    size_t _cycle_index{};              //!< Position in the ProbeBandwidth gain cycle
+    uint64_t _probe_rtt_done_ms{};      //!< When the current ProbeRTT phase ends
+
+    //! \returns the windowed maximum delivery rate, in bytes per millisecond
+    double bottleneck_bandwidth() const;
+
+    //! \returns the estimated bandwidth-delay product, in bytes
+    double bdp() const;
+
+    //! Finish a round trip at time `now_ms` and advance the state machine
+    void end_round(const uint64_t now_ms);
+
+  public:
+    explicit BBRCongestionController(const size_t mss);
+
+    size_t window() const override { return _cwnd; }
+    void on_ack(const CongestionAck &ack) override;
+    void on_timeout(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    void on_fast_retransmit(const size_t bytes_in_flight, const uint64_t now_ms) override;
+    std::string name() const override { return "BBR"; }
+
+    //! \returns the current phase of the state machine
+    Mode mode() const { return _mode; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TCP_CONGESTION_CONTROL_HH
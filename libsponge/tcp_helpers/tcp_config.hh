@@ -14,12 +14,40 @@ class TCPConfig {
     static constexpr size_t DEFAULT_CAPACITY = 64000;  //!< Default capacity
     static constexpr size_t MAX_PAYLOAD_SIZE = 1452;   //!< Max TCP payload that fits in either IPv4 or UDP datagram
     static constexpr uint16_t TIMEOUT_DFLT = 1000;     //!< Default re-transmit timeout is 1 second
+    static constexpr uint16_t RTO_MIN_DFLT = 200;      //!< Default lower bound on an estimated re-transmit timeout
+    static constexpr uint16_t RTO_MAX_DFLT = 60000;    //!< Default upper bound on the re-transmit timeout
     static constexpr unsigned MAX_RETX_ATTEMPTS = 8;   //!< Maximum re-transmit attempts before giving up
+    static constexpr unsigned DUPACK_THRESHOLD = 3;    //!< Duplicate ACKs that trigger a fast retransmit
+    static constexpr uint8_t MAX_WINDOW_SCALE = 14;    //!< Largest window-scale shift count (RFC 7323)
+
+    //! Congestion-control algorithms for the TCPSender (see tcp_congestion_control.hh)
+    enum class CongestionControl {
+        None,   //!< No congestion window: send whatever the receiver's window allows
+        Reno,   //!< Slow start and AIMD (RFC 5681), with NewReno fast recovery (RFC 6582)
+        Cubic,  //!< CUBIC (RFC 8312)
+        BBR     //!< Simplified BBR, driven by bandwidth and round-trip time estimates
+    };
 
     uint16_t rt_timeout = TIMEOUT_DFLT;       //!< Initial value of the retransmission timeout, in milliseconds
     size_t recv_capacity = DEFAULT_CAPACITY;  //!< Receive capacity, in bytes
     size_t send_capacity = DEFAULT_CAPACITY;  //!< Sender capacity, in bytes
     std::optional<WrappingInt32> fixed_isn{};
+    CongestionControl congestion_control = CongestionControl::None;  //!< Sender's congestion-control algorithm
+    bool fast_retransmit = false;  //!< Retransmit after DUPACK_THRESHOLD duplicate ACKs, not only on timeout
+    bool adaptive_rto = false;     //!< Estimate the re-transmit timeout from measured RTTs (RFC 6298)
+    uint16_t rto_min = RTO_MIN_DFLT;  //!< Lower bound on the estimated re-transmit timeout, in milliseconds
+    uint16_t rto_max = RTO_MAX_DFLT;  //!< Upper bound on the (backed-off) adaptive re-transmit timeout
+    bool sack = false;  //!< Offer SACK on the SYN, and retransmit only the holes that SACK blocks reveal (RFC 2018)
+    bool window_scaling = false;  //!< Offer window scaling on the SYN, so windows can exceed 64 KiB (RFC 7323)
+
+    //! \returns the smallest window-scale shift count that lets the window field describe `recv_capacity` bytes
+    uint8_t window_scale() const {
+        uint8_t shift = 0;
+        while (shift < MAX_WINDOW_SCALE && (recv_capacity >> shift) > UINT16_MAX) {
+            shift++;
+        }
+        return shift;
+    }
 };
 
 //! Config for classes derived from FdAdapter
@@ -1,9 +1,88 @@
 #include "tcp_header.hh"
 
+#include <algorithm>
 #include <sstream>
 
 using namespace std;
 
+//! \name TCP option kinds ([RFC 793](\ref rfc::rfc793), RFC 2018 and RFC 7323)
+//!@{
+static constexpr uint8_t OPTION_END = 0;
+static constexpr uint8_t OPTION_NOP = 1;
+static constexpr uint8_t OPTION_MSS = 2;
+static constexpr uint8_t OPTION_WINDOW_SCALE = 3;
+static constexpr uint8_t OPTION_SACK_PERMITTED = 4;
+static constexpr uint8_t OPTION_SACK = 5;
+static constexpr uint8_t OPTION_TIMESTAMPS = 8;
+//!@}
+
+//! \name Lengths of TCP options, including their kind and length fields
+//!@{
+static constexpr size_t OPTION_HEADER_LENGTH = 2;
+static constexpr size_t MSS_LENGTH = 4;
+static constexpr size_t WINDOW_SCALE_LENGTH = 3;
+static constexpr size_t SACK_PERMITTED_LENGTH = 2;
+static constexpr size_t TIMESTAMPS_LENGTH = 10;
+static constexpr size_t SACK_BLOCK_LENGTH = 8;  //!< Each block of a SACK option
+//!@}
+
+//! \param[in,out] header is the TCPHeader that receives the options it supports
+//! \param[in] options is the option space of the header (everything between the fixed header and the data)
+//! \details Unknown options, and known ones with the wrong length, are skipped. A malformed option
+//! length ends the option list, as if it were an end-of-option-list.
+static void parse_options(TCPHeader &header, const Buffer &options) {
+    NetParser p{options};
+    while (p.buffer().size() > 0) {
+        const uint8_t kind = p.u8();
+        if (kind == OPTION_END) {
+            break;
+        }
+        if (kind == OPTION_NOP) {
+            continue;
+        }
+
+        const uint8_t len = p.u8();
+        if (p.error() or len < OPTION_HEADER_LENGTH or len - OPTION_HEADER_LENGTH > p.buffer().size()) {
+            break;
+        }
+
+        if (kind == OPTION_MSS and len == MSS_LENGTH) {
+            header.mss = p.u16();
+        } else if (kind == OPTION_WINDOW_SCALE and len == WINDOW_SCALE_LENGTH) {
+            header.window_scale = p.u8();
+        } else if (kind == OPTION_SACK_PERMITTED and len == SACK_PERMITTED_LENGTH) {
+            header.sack_permitted = true;
+        } else if (kind == OPTION_TIMESTAMPS and len == TIMESTAMPS_LENGTH) {
+            const uint32_t value = p.u32();
+            const uint32_t echo_reply = p.u32();
+            header.timestamps = TCPTimestamps{value, echo_reply};
+        } else if (kind == OPTION_SACK and (len - OPTION_HEADER_LENGTH) % SACK_BLOCK_LENGTH == 0) {
+            for (size_t i = 0; i < (len - OPTION_HEADER_LENGTH) / SACK_BLOCK_LENGTH; i++) {
+                const WrappingInt32 left{p.u32()};
+                const WrappingInt32 right{p.u32()};
+                header.sack_blocks.push_back({left, right});
+            }
+        } else {
+            p.remove_prefix(len - OPTION_HEADER_LENGTH);
+        }
+    }
+}
+
+//! \returns the length of the options other than SACK, unpadded
+static size_t fixed_options_length(const TCPHeader &header) {
+    return (header.mss.has_value() ? MSS_LENGTH : 0) + (header.window_scale.has_value() ? WINDOW_SCALE_LENGTH : 0) +
+           (header.sack_permitted ? SACK_PERMITTED_LENGTH : 0) +
+           (header.timestamps.has_value() ? TIMESTAMPS_LENGTH : 0);
+}
+
+//! \returns the number of SACK blocks that fit in `room` bytes
+static size_t sack_blocks_that_fit(const TCPHeader &header, const size_t room) {
+    if (room < OPTION_HEADER_LENGTH + SACK_BLOCK_LENGTH) {
+        return 0;
+    }
+    return min(header.sack_blocks.size(), (room - OPTION_HEADER_LENGTH) / SACK_BLOCK_LENGTH);
+}
+
 //! \param[in,out] p is a NetParser from which the TCP fields will be extracted
 //! \returns a ParseResult indicating success or the reason for failure
 //! \details It is important to check for (at least) the following potential errors
@@ -15,13 +94,19 @@ using namespace std;
 //! - there is less data in the header than the `doff` field claims
 //! - the checksum is bad
 ParseResult TCPHeader::parse(NetParser &p) {
-    sport = p.u16();                 // source port
-    dport = p.u16();                 // destination port
-    seqno = WrappingInt32{p.u32()};  // sequence number
-    ackno = WrappingInt32{p.u32()};  // ack number
-    doff = p.u8() >> 4;              // data offset
+    // the length of the fixed part is checked once, and then its fields are decoded in place
+    const uint8_t *fixed = p.peek(LENGTH);
+    if (fixed == nullptr) {
+        return p.get_error();
+    }
+
+    sport = NetParser::load_u16(fixed);                     // source port
+    dport = NetParser::load_u16(fixed + 2);                 // destination port
+    seqno = WrappingInt32{NetParser::load_u32(fixed + 4)};  // sequence number
+    ackno = WrappingInt32{NetParser::load_u32(fixed + 8)};  // ack number
+    doff = fixed[12] >> 4;                                  // data offset
 
-    const uint8_t fl_b = p.u8();                  // byte including flags
+    const uint8_t fl_b = fixed[13];               // byte including flags
     urg = static_cast<bool>(fl_b & 0b0010'0000);  // binary literals and ' digit separator since C++14!!!
     ack = static_cast<bool>(fl_b & 0b0001'0000);
     psh = static_cast<bool>(fl_b & 0b0000'1000);
@@ -29,52 +114,116 @@ ParseResult TCPHeader::parse(NetParser &p) {
     syn = static_cast<bool>(fl_b & 0b0000'0010);
     fin = static_cast<bool>(fl_b & 0b0000'0001);
 
-    win = p.u16();    // window size
-    cksum = p.u16();  // checksum
-    uptr = p.u16();   // urgent pointer
+    win = NetParser::load_u16(fixed + 14);    // window size
+    cksum = NetParser::load_u16(fixed + 16);  // checksum
+    uptr = NetParser::load_u16(fixed + 18);   // urgent pointer
+
+    p.remove_prefix(LENGTH);
 
     if (doff < 5) {
         return ParseResult::HeaderTooShort;
     }
 
-    // skip any options or anything extra in the header
+    // the options are whatever is left of the header
+    Buffer options = p.buffer();
     p.remove_prefix(doff * 4 - TCPHeader::LENGTH);
 
     if (p.error()) {
         return p.get_error();
     }
 
+    options.remove_suffix(p.buffer().size());
+    mss.reset();
+    window_scale.reset();
+    sack_permitted = false;
+    timestamps.reset();
+    sack_blocks.clear();
+    parse_options(*this, options);
+
     return ParseResult::NoError;
 }
 
+size_t TCPHeader::options_length() const {
+    size_t len = fixed_options_length(*this);
+    const size_t n_blocks = sack_blocks_that_fit(*this, MAX_OPTIONS_LENGTH - min(len, MAX_OPTIONS_LENGTH));
+    if (n_blocks > 0) {
+        len += OPTION_HEADER_LENGTH + SACK_BLOCK_LENGTH * n_blocks;
+    }
+    return (len + 3) / 4 * 4;
+}
+
 //! Serialize the TCPHeader to a string (does not recompute the checksum)
 string TCPHeader::serialize() const {
+    string ret(4 * doff, 0);
+    serialize_into(reinterpret_cast<uint8_t *>(ret.data()), ret.size());
+    return ret;
+}
+
+//! \param[out] out is where to write the header
+//! \param[in] size is the room at `out`, which must be at least `4 * doff` bytes
+//! \returns the number of bytes written, `4 * doff`
+//! \note Does not recompute the checksum
+size_t TCPHeader::serialize_into(uint8_t *out, const size_t size) const {
     // sanity check
     if (doff < 5) {
         throw runtime_error("TCP header too short");
     }
+    if (size < 4 * doff) {
+        throw runtime_error("no room to serialize TCP header");
+    }
 
-    string ret;
-    ret.reserve(4 * doff);
-
-    NetUnparser::u16(ret, sport);              // source port
-    NetUnparser::u16(ret, dport);              // destination port
-    NetUnparser::u32(ret, seqno.raw_value());  // sequence number
-    NetUnparser::u32(ret, ackno.raw_value());  // ack number
-    NetUnparser::u8(ret, doff << 4);           // data offset
+    uint8_t *p = out;
+    p = NetUnparser::u16(p, sport);              // source port
+    p = NetUnparser::u16(p, dport);              // destination port
+    p = NetUnparser::u32(p, seqno.raw_value());  // sequence number
+    p = NetUnparser::u32(p, ackno.raw_value());  // ack number
+    p = NetUnparser::u8(p, doff << 4);           // data offset
 
     const uint8_t fl_b = (urg ? 0b0010'0000 : 0) | (ack ? 0b0001'0000 : 0) | (psh ? 0b0000'1000 : 0) |
                          (rst ? 0b0000'0100 : 0) | (syn ? 0b0000'0010 : 0) | (fin ? 0b0000'0001 : 0);
-    NetUnparser::u8(ret, fl_b);  // flags
-    NetUnparser::u16(ret, win);  // window size
+    p = NetUnparser::u8(p, fl_b);  // flags
+    p = NetUnparser::u16(p, win);  // window size
 
-    NetUnparser::u16(ret, cksum);  // checksum
+    p = NetUnparser::u16(p, cksum);  // checksum
 
-    NetUnparser::u16(ret, uptr);  // urgent pointer
+    p = NetUnparser::u16(p, uptr);  // urgent pointer
 
-    ret.resize(4 * doff);  // expand header to advertised size
+    // options, as far as they fit in the advertised size
+    size_t room = 4 * doff - LENGTH;
+    const auto begin_option = [&](const uint8_t kind, const size_t len) {
+        if (len > room) {
+            return false;
+        }
+        p = NetUnparser::u8(p, kind);
+        p = NetUnparser::u8(p, len);
+        room -= len;
+        return true;
+    };
+    if (mss.has_value() and begin_option(OPTION_MSS, MSS_LENGTH)) {
+        p = NetUnparser::u16(p, mss.value());
+    }
+    if (window_scale.has_value() and begin_option(OPTION_WINDOW_SCALE, WINDOW_SCALE_LENGTH)) {
+        p = NetUnparser::u8(p, window_scale.value());
+    }
+    if (sack_permitted) {
+        begin_option(OPTION_SACK_PERMITTED, SACK_PERMITTED_LENGTH);
+    }
+    if (timestamps.has_value() and begin_option(OPTION_TIMESTAMPS, TIMESTAMPS_LENGTH)) {
+        p = NetUnparser::u32(p, timestamps->value);
+        p = NetUnparser::u32(p, timestamps->echo_reply);
+    }
+    const size_t n_blocks = sack_blocks_that_fit(*this, room);
+    if (n_blocks > 0) {
+        begin_option(OPTION_SACK, OPTION_HEADER_LENGTH + SACK_BLOCK_LENGTH * n_blocks);
+        for (size_t i = 0; i < n_blocks; i++) {
+            p = NetUnparser::u32(p, sack_blocks[i].left.raw_value());
+            p = NetUnparser::u32(p, sack_blocks[i].right.raw_value());
+        }
+    }
 
-    return ret;
+    fill(p, out + 4 * doff, 0);  // expand header to advertised size, ending the option list with zeros
+
+    return 4 * doff;
 }
 
 //! \returns A string with the header's contents
@@ -89,14 +238,39 @@ string TCPHeader::to_string() const {
        << " fin: " << fin << '\n'
        << "TCP winsize: " << +win << '\n'
        << "TCP cksum: " << +cksum << '\n'
-       << "TCP uptr: " << +uptr << '\n';
+       << "TCP uptr: " << +uptr << '\n'
+       << "TCP MSS: " << (mss.has_value() ? std::to_string(mss.value()) : "none") << '\n'
+       << "TCP window scale: " << (window_scale.has_value() ? std::to_string(window_scale.value()) : "none") << '\n'
+       << "TCP SACK permitted: " << sack_permitted << '\n';
+    if (timestamps.has_value()) {
+        ss << "TCP timestamps: TSval " << timestamps->value << " TSecr " << timestamps->echo_reply << '\n';
+    }
+    for (const auto &block : sack_blocks) {
+        ss << "TCP SACK block: [" << block.left << ", " << block.right << ")\n";
+    }
     return ss.str();
 }
 
 string TCPHeader::summary() const {
     stringstream ss{};
     ss << "Header(flags=" << (syn ? "S" : "") << (ack ? "A" : "") << (rst ? "R" : "") << (fin ? "F" : "")
-       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win << ")";
+       << ",seqno=" << seqno << ",ack=" << ackno << ",win=" << win;
+    if (mss.has_value()) {
+        ss << ",mss=" << mss.value();
+    }
+    if (window_scale.has_value()) {
+        ss << ",wscale=" << +window_scale.value();
+    }
+    if (sack_permitted) {
+        ss << ",sackOK";
+    }
+    if (timestamps.has_value()) {
+        ss << ",ts=" << timestamps->value << "/" << timestamps->echo_reply;
+    }
+    for (const auto &block : sack_blocks) {
+        ss << ",sack=[" << block.left << "," << block.right << ")";
+    }
+    ss << ")";
     return ss.str();
 }
 
@@ -104,5 +278,6 @@ bool TCPHeader::operator==(const TCPHeader &other) const {
     // TODO(aozdemir) more complete check (right now we omit cksum, src, dst
     return seqno == other.seqno && ackno == other.ackno && doff == other.doff && urg == other.urg && ack == other.ack &&
            psh == other.psh && rst == other.rst && syn == other.syn && fin == other.fin && win == other.win &&
-           uptr == other.uptr;
+           uptr == other.uptr && mss == other.mss && window_scale == other.window_scale &&
+           sack_permitted == other.sack_permitted && timestamps == other.timestamps && sack_blocks == other.sack_blocks;
 }
@@ -4,10 +4,34 @@
 #include "parser.hh"
 #include "wrapping_integers.hh"
 
+#include <optional>
+#include <vector>
+
+//! \brief A SACK block (RFC 2018): the receiver holds the sequence numbers in [left, right)
+struct SACKBlock {
+    WrappingInt32 left;   //!< first sequence number of the block
+    WrappingInt32 right;  //!< sequence number just past the block
+
+    bool operator==(const SACKBlock &other) const { return left == other.left && right == other.right; }
+};
+
+//! \brief The contents of a timestamps option (RFC 7323)
+struct TCPTimestamps {
+    uint32_t value;       //!< TSval: the sender's clock when it sent the segment
+    uint32_t echo_reply;  //!< TSecr: the most recent TSval received from the peer
+
+    bool operator==(const TCPTimestamps &other) const {
+        return value == other.value && echo_reply == other.echo_reply;
+    }
+};
+
 //! \brief [TCP](\ref rfc::rfc793) segment header
-//! \note TCP options are not supported
+//! \note The supported TCP options are maximum segment size, window scale and timestamps (RFC 7323),
+//! and SACK-permitted and SACK (RFC 2018); others are skipped
 struct TCPHeader {
-    static constexpr size_t LENGTH = 20;  //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t LENGTH = 20;              //!< [TCP](\ref rfc::rfc793) header length, not including options
+    static constexpr size_t MAX_OPTIONS_LENGTH = 40;  //!< Room for options after the fixed header
+    static constexpr size_t MAX_SACK_BLOCKS = 4;      //!< SACK blocks that fit in the option space
 
     //! \struct TCPHeader
     //! ~~~{.txt}
@@ -50,12 +74,30 @@ struct TCPHeader {
     uint16_t uptr = 0;          //!< urgent pointer
     //!@}
 
+    //! \name TCP options
+    //! \note The header is always serialized with `doff` words, so set `doff` to make room for the options
+    //! (see options_length()); options that don't fit are left out.
+    //!@{
+    std::optional<uint16_t> mss{};              //!< Maximum segment size the sender can receive, sent on a SYN
+    std::optional<uint8_t> window_scale{};      //!< Shift count for the sender's later window fields, sent on a SYN
+    bool sack_permitted = false;                //!< SACK-permitted option, sent on a SYN
+    std::optional<TCPTimestamps> timestamps{};  //!< Timestamps option
+    std::vector<SACKBlock> sack_blocks{};       //!< SACK option: blocks held above the ackno, most recent first
+    //!@}
+
     //! Parse the TCP fields from the provided NetParser
     ParseResult parse(NetParser &p);
 
+    //! \returns the length of the options, padded to a multiple of four bytes
+    //! \note If they don't all fit in MAX_OPTIONS_LENGTH, this counts only the SACK blocks that do.
+    size_t options_length() const;
+
     //! Serialize the TCP fields
     std::string serialize() const;
 
+    //! Serialize the TCP fields into caller-provided storage, without allocating
+    size_t serialize_into(uint8_t *out, const size_t size) const;
+
     //! Return a string containing a header in human-readable format
     std::string to_string() const;
 
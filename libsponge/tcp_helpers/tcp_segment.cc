@@ -3,43 +3,102 @@
 #include "parser.hh"
 #include "util.hh"
 
+#include <stdexcept>
 #include <variant>
 
 using namespace std;
 
 //! \param[in] buffer string/Buffer to be parsed
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \details The header and the payload are summed separately, so the payload's sum is kept for payload_sum().
 ParseResult TCPSegment::parse(const Buffer buffer, const uint32_t datagram_layer_checksum) {
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(buffer);
-    if (check.value()) {
-        return ParseResult::BadChecksum;
-    }
-
     NetParser p{buffer};
     _header.parse(p);
     _payload = p.buffer();
-    return p.get_error();
+    _payload_sum.reset();
+
+    if (p.error()) {
+        InternetChecksum check(datagram_layer_checksum);
+        check.add(buffer);
+        return check.value() ? ParseResult::BadChecksum : p.get_error();
+    }
+
+    // the header is a whole number of 32-bit words, so the payload's sum lines up with it
+    InternetChecksum check(datagram_layer_checksum + payload_sum());
+    check.add(buffer.str().substr(0, buffer.size() - _payload.size()));
+    return check.value() ? ParseResult::BadChecksum : ParseResult::NoError;
 }
 
 size_t TCPSegment::length_in_sequence_space() const {
     return payload().str().size() + (header().syn ? 1 : 0) + (header().fin ? 1 : 0);
 }
 
+uint16_t TCPSegment::payload_sum() const {
+    if (not _payload_sum.has_value()) {
+        InternetChecksum check;
+        check.add(_payload);
+        _payload_sum = check.partial_sum();
+    }
+    return _payload_sum.value();
+}
+
+//! Offset of the checksum field in a serialized TCPHeader
+static constexpr size_t CHECKSUM_OFFSET = 16;
+
+//! Checksum a serialized header, whatever its checksum field held, and store the checksum in it
+//! \param[in] initial_sum is the sum of the pseudo-header and the payload
+static void set_checksum(uint8_t *header, const size_t header_len, const uint32_t initial_sum) {
+    header[CHECKSUM_OFFSET] = header[CHECKSUM_OFFSET + 1] = 0;
+    InternetChecksum check(initial_sum);
+    check.add({reinterpret_cast<const char *>(header), header_len});
+    NetUnparser::u16(header + CHECKSUM_OFFSET, check.value());
+}
+
 //! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
 BufferList TCPSegment::serialize(const uint32_t datagram_layer_checksum) const {
-    TCPHeader header_out = _header;
-    header_out.cksum = 0;
+    PacketBuffer header_out(4 * _header.doff);
+    _header.serialize_into(reinterpret_cast<uint8_t *>(header_out.data()), header_out.size());
 
-    // calculate checksum -- taken over entire segment
-    InternetChecksum check(datagram_layer_checksum);
-    check.add(header_out.serialize());
-    check.add(_payload);
-    header_out.cksum = check.value();
+    // calculate checksum -- taken over entire segment, with the payload's part cached
+    set_checksum(reinterpret_cast<uint8_t *>(header_out.data()),
+                 header_out.size(),
+                 datagram_layer_checksum + payload_sum());
 
     BufferList ret;
-    ret.append(header_out.serialize());
+    ret.append(Buffer(move(header_out)));
     ret.append(_payload);
 
     return ret;
 }
+
+//! \param[in,out] packet is the buffer to append the segment to; its capacity is reused
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+void TCPSegment::serialize_into(string &packet, const uint32_t datagram_layer_checksum) const {
+    const size_t start = packet.size();
+    packet.resize(start + serialized_size());
+    serialize_into(reinterpret_cast<uint8_t *>(packet.data()) + start, serialized_size(), datagram_layer_checksum);
+}
+
+//! \param[out] out is where to write the segment
+//! \param[in] size is the room at `out`, which must be at least serialized_size()
+//! \param[in] datagram_layer_checksum pseudo-checksum from the lower-layer protocol
+//! \returns the number of bytes written
+//! \details Unless the payload's sum is already known, it is summed while it is copied.
+size_t TCPSegment::serialize_into(uint8_t *out, const size_t size, const uint32_t datagram_layer_checksum) const {
+    if (size < serialized_size()) {
+        throw runtime_error("no room to serialize TCP segment");
+    }
+
+    const size_t header_len = _header.serialize_into(out, size);
+    char *payload_out = reinterpret_cast<char *>(out + header_len);
+    if (not _payload_sum.has_value()) {
+        InternetChecksum payload_check;
+        payload_check.add_and_copy(_payload, payload_out);
+        _payload_sum = payload_check.partial_sum();
+    } else {
+        _payload.str().copy(payload_out, _payload.size());
+    }
+
+    set_checksum(out, header_len, datagram_layer_checksum + _payload_sum.value());
+    return header_len + _payload.size();
+}
@@ -5,12 +5,16 @@
 #include "tcp_header.hh"
 
 #include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
 
 //! \brief [TCP](\ref rfc::rfc793) segment
 class TCPSegment {
   private:
     TCPHeader _header{};
     Buffer _payload{};
+    mutable std::optional<uint16_t> _payload_sum{};  //!< Cached InternetChecksum::partial_sum() of the payload
 
   public:
     //! \brief Parse the segment from a string
@@ -19,15 +23,34 @@ class TCPSegment {
     //! \brief Serialize the segment to a string
     BufferList serialize(const uint32_t datagram_layer_checksum = 0) const;
 
+    //! \brief Serialize the segment onto the end of `packet`, copying the payload in the same pass that sums it
+    void serialize_into(std::string &packet, const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \brief Serialize the segment into caller-provided storage, without allocating
+    size_t serialize_into(uint8_t *out, const size_t size, const uint32_t datagram_layer_checksum = 0) const;
+
+    //! \brief Number of bytes that serialize_into() writes
+    size_t serialized_size() const { return 4 * _header.doff + _payload.size(); }
+
     //! \name Accessors
     //!@{
     const TCPHeader &header() const { return _header; }
     TCPHeader &header() { return _header; }
 
     const Buffer &payload() const { return _payload; }
-    Buffer &payload() { return _payload; }
+
+    //! \brief Replace the payload, forgetting the cached sum of the old one
+    void set_payload(Buffer payload) {
+        _payload = std::move(payload);
+        _payload_sum.reset();
+    }
     //!@}
 
+    //! \brief Partial Internet checksum of the payload, computed once and then kept with the segment
+    //! \details With it, serializing the segment again after the header changes (e.g. to retransmit it with a
+    //! new ackno and window) only has to sum the header.
+    uint16_t payload_sum() const;
+
     //! \brief Segment's length in sequence space
     //! \note Equal to payload length plus one byte if SYN is set, plus one byte if FIN is set
     size_t length_in_sequence_space() const;
@@ -1,5 +1,7 @@
 #include "tcp_receiver.hh"
 
+#include <algorithm>
+
 // Dummy implementation of a TCP receiver
 
 // For Lab 2, please replace with a real implementation that passes the
@@ -10,6 +12,12 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+//! \param[in] config the receive capacity and whether to offer window scaling
+TCPReceiver::TCPReceiver(const TCPConfig &config) : TCPReceiver(config.recv_capacity) {
+    if (config.window_scaling)
+        _window_scale = config.window_scale();
+}
+
 void TCPReceiver::segment_received(const TCPSegment &seg) {
     // set the initial sequence number if necessary
     if (seg.header().syn) {
@@ -21,15 +29,21 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
         // init `_init_seqno` and `_next_ackno`
         _init_seqno.emplace(seg.header().seqno);
         _next_ackno.emplace(_init_seqno.value() + 1);
+        _sack_permitted = seg.header().sack_permitted;
+        // window scaling is in effect only if both SYNs offer it
+        if (_window_scale.has_value() && seg.header().window_scale.has_value())
+            _peer_window_scale = min(seg.header().window_scale.value(), TCPConfig::MAX_WINDOW_SCALE);
     };
 
     if (_syn_received) {
-        // push substring into StreamReassembler
-        const std::string data = seg.payload().copy();
+        // push substring into StreamReassembler, which keeps (slices of) the payload Buffer without copying it
         const uint64_t stream_index =
             unwrap(seg.header().seqno + seg.header().syn, _init_seqno.value(), _reassembler.get_abs_seqno()) - 1;
         const bool eof = seg.header().fin;
-        _reassembler.push_substring(data, stream_index, eof);
+        // remember where the latest out-of-order data went, so that its SACK block can be reported first
+        if (stream_index > _reassembler.get_abs_seqno() && seg.payload().size() > 0)
+            _last_held_index = stream_index;
+        _reassembler.push_substring(seg.payload(), stream_index, eof);
         // evaluate next ackno
         _next_ackno.emplace(wrap(_reassembler.get_abs_seqno(), _init_seqno.value()) + 1);
 
@@ -40,4 +54,38 @@ void TCPReceiver::segment_received(const TCPSegment &seg) {
 
 optional<WrappingInt32> TCPReceiver::ackno() const { return _next_ackno; }
 
+vector<SACKBlock> TCPReceiver::sack_blocks() const {
+    vector<SACKBlock> blocks;
+    if (!_sack_permitted)
+        return blocks;
+
+    // the reassembler holds stream indices, which are one less than the absolute seqnos (the SYN comes first)
+    const auto ranges = _reassembler.held_ranges();
+    const auto to_block = [&](const pair<uint64_t, uint64_t> &range) {
+        return SACKBlock{wrap(range.first + 1, _init_seqno.value()), wrap(range.second + 1, _init_seqno.value())};
+    };
+    const auto latest = find_if(ranges.begin(), ranges.end(), [&](const pair<uint64_t, uint64_t> &range) {
+        return _last_held_index.has_value() && range.first <= *_last_held_index && *_last_held_index < range.second;
+    });
+    if (latest != ranges.end())
+        blocks.push_back(to_block(*latest));
+    for (auto iter = ranges.rbegin(); iter != ranges.rend() && blocks.size() < TCPHeader::MAX_SACK_BLOCKS; ++iter) {
+        if (iter.base() - 1 != latest)
+            blocks.push_back(to_block(*iter));
+    };
+    return blocks;
+}
+
 size_t TCPReceiver::window_size() const { return _capacity - _reassembler.stream_out().buffer_size(); }
+
+uint16_t TCPReceiver::window_field() const {
+    const uint8_t shift = _peer_window_scale.has_value() ? _window_scale.value() : 0;
+    return min<size_t>(window_size() >> shift, UINT16_MAX);
+}
+
+//! \param[in] header the header of a segment from the peer
+size_t TCPReceiver::peer_window(const TCPHeader &header) const {
+    if (header.syn || !_peer_window_scale.has_value())
+        return header.win;
+    return size_t{header.win} << _peer_window_scale.value();
+}
@@ -3,10 +3,12 @@
 
 #include "byte_stream.hh"
 #include "stream_reassembler.hh"
+#include "tcp_config.hh"
 #include "tcp_segment.hh"
 #include "wrapping_integers.hh"
 
 #include <optional>
+#include <vector>
 
 //! \brief The "receiver" part of a TCP implementation.
 
@@ -24,13 +26,36 @@ class TCPReceiver {
     std::optional<WrappingInt32> _next_ackno;
     bool _syn_received;
 
+    //! Whether the peer's SYN carried the SACK-permitted option
+    bool _sack_permitted;
+
+    //! The stream index of the most recently received segment that arrived out of order
+    std::optional<uint64_t> _last_held_index;
+
+    //! The window-scale shift count that our SYN offers, if window scaling is enabled
+    std::optional<uint8_t> _window_scale;
+
+    //! The peer's window-scale shift count, once both SYNs have offered window scaling (RFC 7323)
+    std::optional<uint8_t> _peer_window_scale;
+
   public:
     //! \brief Construct a TCP receiver
     //!
     //! \param capacity the maximum number of bytes that the receiver will
     //!                 store in its buffers at any give time.
     TCPReceiver(const size_t capacity)
-        : _reassembler(capacity), _capacity{capacity}, _init_seqno{}, _next_ackno{}, _syn_received{false} {}
+        : _reassembler(capacity)
+        , _capacity{capacity}
+        , _init_seqno{}
+        , _next_ackno{}
+        , _syn_received{false}
+        , _sack_permitted{false}
+        , _last_held_index{}
+        , _window_scale{}
+        , _peer_window_scale{} {}
+
+    //! \brief Construct a TCP receiver with the receive capacity and window scaling in a TCPConfig
+    explicit TCPReceiver(const TCPConfig &config);
 
     //! \name Accessors to provide feedback to the remote TCPSender
     //!@{
@@ -53,8 +78,29 @@ class TCPReceiver {
     //! accepted by the receiver) and (b) the sequence number of the
     //! beginning of the window (the ackno).
     size_t window_size() const;
+
+    //! \brief The value for the window field of segments sent to the peer
+    //!
+    //! This is window_size() scaled down by our window-scale shift count, once both sides have
+    //! offered window scaling, and capped at what the field can hold.
+    uint16_t window_field() const;
+
+    //! \brief The SACK blocks (RFC 2018) that should be sent to the peer
+    //! \returns empty unless the peer's SYN permitted SACK
+    //!
+    //! These are the ranges of sequence numbers that have been received beyond the ackno,
+    //! at most TCPHeader::MAX_SACK_BLOCKS of them. The block holding the most recently received
+    //! segment comes first, then the others from the highest sequence numbers down.
+    std::vector<SACKBlock> sack_blocks() const;
+
+    //! \brief Whether the peer's SYN carried the SACK-permitted option
+    bool sack_permitted() const { return _sack_permitted; }
     //!@}
 
+    //! \brief The window advertised by a segment from the peer, in bytes (for TCPSender::ack_received)
+    //! \details The window field of a SYN is never scaled.
+    size_t peer_window(const TCPHeader &header) const;
+
     //! \brief number of bytes stored but not yet reassembled
     size_t unassembled_bytes() const { return _reassembler.unassembled_bytes(); }
 
@@ -2,7 +2,10 @@
 
 #include "tcp_config.hh"
 
+#include <algorithm>
+#include <cmath>
 #include <random>
+#include <utility>
 
 // Dummy implementation of a TCP sender
 
@@ -14,63 +17,229 @@ void DUMMY_CODE(Targs &&... /* unused */) {}
 
 using namespace std;
 
+TCPTimer::TCPTimer(TCPTimer &&other) noexcept
+    : _is_running(other._is_running)
+    , _ms_since_started(other._ms_since_started)
+    , _current_retransmission_timeout(other._current_retransmission_timeout)
+    , _wheel(other._wheel)
+    , _on_expiry(move(other._on_expiry))
+    , _wheel_timer(exchange(other._wheel_timer, nullopt)) {}
+
+TCPTimer &TCPTimer::operator=(TCPTimer &&other) noexcept {
+    if (this != &other) {
+        if (_wheel and _wheel_timer)
+            _wheel->cancel(*_wheel_timer);
+        _is_running = other._is_running;
+        _ms_since_started = other._ms_since_started;
+        _current_retransmission_timeout = other._current_retransmission_timeout;
+        _wheel = other._wheel;
+        _on_expiry = move(other._on_expiry);
+        _wheel_timer = exchange(other._wheel_timer, nullopt);
+    }
+    return *this;
+}
+
+TCPTimer::~TCPTimer() {
+    if (_wheel and _wheel_timer)
+        _wheel->cancel(*_wheel_timer);
+}
+
+//! \param[in] wheel the wheel on which to arm a timer whenever this one is running
+//! \param[in] on_expiry called when the wheel's timer fires, i.e. when add() would make this timer expire
+void TCPTimer::set_wheel(TimerWheel &wheel, const TimerWheel::CallbackT &on_expiry) {
+    if (_wheel and _wheel_timer)
+        _wheel->cancel(*_wheel_timer);
+    _wheel_timer.reset();
+    _wheel = &wheel;
+    _on_expiry = on_expiry;
+    _rearm();
+}
+
+void TCPTimer::_rearm() {
+    if (not _wheel)
+        return;
+    if (_wheel_timer)
+        _wheel->cancel(*_wheel_timer);
+    _wheel_timer.reset();
+    if (_is_running) {
+        const size_t elapsed = min(_ms_since_started, _current_retransmission_timeout);
+        _wheel_timer = _wheel->add(_current_retransmission_timeout - elapsed, _on_expiry);
+    }
+}
+
 //! \param[in] capacity the capacity of the outgoing byte stream
 //! \param[in] retx_timeout the initial amount of time to wait before retransmitting the oldest outstanding segment
 //! \param[in] fixed_isn the Initial Sequence Number to use, if set (otherwise uses a random ISN)
 TCPSender::TCPSender(const size_t capacity, const uint16_t retx_timeout, const std::optional<WrappingInt32> fixed_isn)
     : _isn(fixed_isn.value_or(WrappingInt32{random_device()()}))
     , _initial_retransmission_timeout{retx_timeout}
-    , _stream(capacity)
+    , _stream(capacity, ByteStream::Storage::Chunked)
     , _retransmission_timer(retx_timeout) {}
 
-void TCPSender::_remove_acked_outstanding_segments() {
-    for (auto iter = _segments_outstanding.begin(); iter != _segments_outstanding.end(); ) {
-        TCPSegment tcp_segment = *iter;
-        // if the `ackno` is greater than all of the sequence numbers in the segment, discard the piece from outstanding segments
-        if (_ackno >= unwrap(tcp_segment.header().seqno + tcp_segment.length_in_sequence_space(), _isn, _next_seqno)) {
-            iter = _segments_outstanding.erase(iter);
-        } else iter++;
+//! \param[in] config the sender capacity, initial retransmission timeout, ISN, congestion-control algorithm
+//! and loss-recovery options
+TCPSender::TCPSender(const TCPConfig &config) : TCPSender(config.send_capacity, config.rt_timeout, config.fixed_isn) {
+    _congestion_controller = make_congestion_controller(config.congestion_control);
+    _fast_retransmit = config.fast_retransmit;
+    _sack = config.sack;
+    if (config.window_scaling)
+        _window_scale = config.window_scale();
+    _adaptive_rto = config.adaptive_rto;
+    _rto_min = config.rto_min;
+    _rto_max = config.rto_max;
+}
+
+//! \param[in] rtt_ms the time from sending a segment to its acknowledgment, in milliseconds
+void RTTEstimator::add_sample(const uint64_t rtt_ms) {
+    const double rtt = rtt_ms;
+    if (!_srtt.has_value()) {
+        _srtt = rtt;
+        _rttvar = rtt / 2;
+        return;
+    }
+    // RTTVAR must be updated with the old SRTT (alpha = 1/8, beta = 1/4)
+    _rttvar = 0.75 * _rttvar + 0.25 * abs(*_srtt - rtt);
+    _srtt = 0.875 * *_srtt + 0.125 * rtt;
+}
+
+optional<size_t> RTTEstimator::rto() const {
+    if (!_srtt.has_value())
+        return {};
+    return static_cast<size_t>(ceil(*_srtt + max(1.0, 4 * _rttvar)));
+}
+
+//! \details Without adaptive_rto, or before the first RTT measurement, this is the initial RTO.
+size_t TCPSender::_fresh_rto() const {
+    if (!_adaptive_rto || !_rtt_estimator.rto().has_value())
+        return _initial_retransmission_timeout;
+    return clamp(*_rtt_estimator.rto(), _rto_min, _rto_max);
+}
+
+void TCPSender::_retransmit_earliest_segment() {
+    if (_segments_outstanding.empty())
+        return;
+    OutstandingSegment &earliest = _segments_outstanding.front();
+    _segments_out.push(earliest.segment);
+    earliest.sent_ms = _time_ms;
+    earliest.retransmitted = true;
+    earliest.resent = true;
+}
+
+//! \details A hole is an outstanding segment below the highest SACKed sequence number that no SACK block
+//! covers. Each hole is retransmitted at most once this way; if the retransmission is lost too, the
+//! retransmission timer recovers it, and the holes may then be resent once more.
+bool TCPSender::_retransmit_next_hole() {
+    for (OutstandingSegment &outstanding : _segments_outstanding) {
+        if (outstanding.seqno >= _highest_sacked)
+            return false;
+        if (!outstanding.sacked && !outstanding.resent) {
+            _segments_out.push(outstanding.segment);
+            outstanding.sent_ms = _time_ms;
+            outstanding.retransmitted = true;
+            outstanding.resent = true;
+            return true;
+        }
     };
+    return false;
 }
 
-char TCPSender::_get_char_indexed_ackno() const {
-    for (auto iter = _segments_outstanding.begin(); iter != _segments_outstanding.end(); ) {
-        TCPSegment tcp_segment = *iter;
-        uint64_t start_seqno = unwrap(tcp_segment.header().seqno, _isn, _next_seqno);
-        uint64_t end_seqno = start_seqno + tcp_segment.length_in_sequence_space();
-        if (start_seqno <= _ackno && _ackno < end_seqno)
-            return tcp_segment.payload().at(0);
+//! \param[in] sack_blocks the SACK blocks of an acknowledgment
+void TCPSender::_update_scoreboard(const vector<SACKBlock> &sack_blocks) {
+    for (const SACKBlock &block : sack_blocks) {
+        const uint64_t left = unwrap(block.left, _isn, _next_seqno);
+        const uint64_t right = unwrap(block.right, _isn, _next_seqno);
+        // ignore blocks that are empty, already acknowledged or beyond what was sent
+        if (left >= right || left < _ackno || right > _next_seqno)
+            continue;
+        _highest_sacked = max(_highest_sacked, right);
+        // the outstanding segments are in sequence-number order, so the covered ones are consecutive
+        auto iter = lower_bound(_segments_outstanding.begin(),
+                                _segments_outstanding.end(),
+                                left,
+                                [](const OutstandingSegment &outstanding, const uint64_t seqno) {
+                                    return outstanding.seqno < seqno;
+                                });
+        for (; iter != _segments_outstanding.end() &&
+               iter->seqno + iter->segment.length_in_sequence_space() <= right;
+             ++iter)
+            iter->sacked = true;
     };
-    cerr << "something is missing out in outstanding segments" << endl;
-    return {};
-}
-
-uint64_t TCPSender::bytes_in_flight() const {
-    uint64_t ans = 0;
-    for (const TCPSegment& tcp_segment : _segments_outstanding) {
-        uint64_t start_seqno = unwrap(tcp_segment.header().seqno, _isn, _next_seqno);
-        uint64_t end_seqno = start_seqno + tcp_segment.length_in_sequence_space();
-        if (_ackno < start_seqno)
-            ans += end_seqno - start_seqno;
-        else if (_ackno < end_seqno) 
-            ans += end_seqno - _ackno;
-        else
-            cerr << "Warning: redundent outstanding segments detected..." << endl;
+}
+
+void TCPSender::_duplicate_ack_received() {
+    if (!_fast_retransmit)
+        return;
+    _duplicate_acks++;
+    // each further duplicate ACK means another segment has left the network, so one more may be sent:
+    // with SACK, that is the next hole if there is one
+    if (_in_fast_recovery) {
+        if (_sack && _retransmit_next_hole())
+            return;
+        if (_congestion_controller)
+            _congestion_controller->on_duplicate_ack(bytes_in_flight());
+        fill_window();
+        return;
+    }
+    // with SACK, the duplicates after a timeout also reveal which of the segments outstanding then are missing
+    if (_in_timeout_recovery && _sack) {
+        _retransmit_next_hole();
+        return;
+    }
+    // the earliest outstanding segment was probably lost; resend it without waiting for the timer (RFC 5681),
+    // unless the duplicates are for data sent before the last recovery began (RFC 6582)
+    if (_duplicate_acks == TCPConfig::DUPACK_THRESHOLD && _ackno >= _recover) {
+        _in_fast_recovery = true;
+        _recover = _next_seqno;
+        if (_congestion_controller)
+            _congestion_controller->on_fast_retransmit(bytes_in_flight(), _time_ms);
+        _retransmit_earliest_segment();
+        fill_window();
+    };
+}
+
+optional<uint64_t> TCPSender::_remove_acked_outstanding_segments() {
+    optional<uint64_t> rtt;
+    bool timed = true;
+    // the outstanding segments are in sequence-number order, so the fully acknowledged ones are at the front
+    while (!_segments_outstanding.empty()) {
+        const OutstandingSegment &earliest = _segments_outstanding.front();
+        // if the `ackno` is greater than all of the sequence numbers in the segment, discard the piece from outstanding segments
+        if (_ackno < earliest.seqno + earliest.segment.length_in_sequence_space())
+            break;
+        // an ACK that covers a retransmitted segment may be for either copy, so it can't be timed
+        timed = timed && !earliest.retransmitted;
+        rtt = _time_ms - earliest.sent_ms;
+        _segments_outstanding.pop_front();
     };
-    return ans;
+    return timed ? rtt : nullopt;
 }
 
+//! \details Every sequence number in [_ackno, _next_seqno) belongs to an outstanding segment,
+//! so nothing needs to be added up.
+uint64_t TCPSender::bytes_in_flight() const { return _next_seqno - _ackno; }
+
 void TCPSender::fill_window() {
     // if the window size is zero, act like the window size is one
     // send a single byte that gets rejected by the receiver
-    size_t assumed_window_size = max(_window_size, 1U);
+    size_t assumed_window_size = max<size_t>(_window_size, 1);
+    // never have more in flight than the congestion window either
+    if (_congestion_controller)
+        assumed_window_size = min(assumed_window_size, _congestion_controller->window());
 
     // reads from ByteStream and sends as many bytes as possible in the form of TCPSegments
     // as long as there are new bytes to be read and spce available in the window
     while (_next_seqno - _ackno < assumed_window_size) {
         TCPSegment tcp_segment_to_send;
-        if (!_syn_sent)
+        if (!_syn_sent) {
             _syn_sent = tcp_segment_to_send.header().syn = true;
+            // announce the MSS, and offer window scaling and SACK (RFC 7323, RFC 2018),
+            // making room for the options in the header
+            tcp_segment_to_send.header().mss = TCPConfig::MAX_PAYLOAD_SIZE;
+            tcp_segment_to_send.header().window_scale = _window_scale;
+            tcp_segment_to_send.header().sack_permitted = _sack;
+            tcp_segment_to_send.header().doff =
+                (TCPHeader::LENGTH + tcp_segment_to_send.header().options_length()) / 4;
+        };
         
         tcp_segment_to_send.header().seqno = _isn + _next_seqno;
         
@@ -84,17 +253,19 @@ void TCPSender::fill_window() {
         if (_stream.input_ended() && !_fin_sent && free_window_size > data_len)
             _fin_sent = tcp_segment_to_send.header().fin = true;
 
-        std::string data = _stream.read(data_len);
-        Buffer buffer(std::move(data));
-        tcp_segment_to_send.payload() = buffer;
+        // the payload shares storage with what the application wrote, unless it spans several writes
+        const BufferList data = _stream.read_buffer(data_len);
+        tcp_segment_to_send.set_payload(data.contiguous());
         // if the segment contains data, send it
         if (tcp_segment_to_send.length_in_sequence_space() > 0) {
+            // sum the payload once, so that neither this segment nor its retransmissions sum it again
+            tcp_segment_to_send.payload_sum();
             _segments_out.push(tcp_segment_to_send);
-            _segments_outstanding.push_back(tcp_segment_to_send);
+            _segments_outstanding.push_back({tcp_segment_to_send, _next_seqno, _time_ms, false, false, false});
 
             // start retransmission running
             if (!_retransmission_timer.is_running() && _window_size)
-                _retransmission_timer.start(_initial_retransmission_timeout);
+                _retransmission_timer.start(_retransmission_timer.get_rto());
 
             _next_seqno += tcp_segment_to_send.length_in_sequence_space();
 
@@ -106,27 +277,62 @@ void TCPSender::fill_window() {
 }
 
 //! \param ackno The remote receiver's ackno (acknowledgment number)
-//! \param window_size The remote receiver's advertised window size
-void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_size) {
+//! \param window_size The remote receiver's advertised window size, in bytes
+//! \param sack_blocks The SACK blocks of the acknowledgment (ignored unless SACK was offered)
+void TCPSender::ack_received(const WrappingInt32 ackno,
+                             const size_t window_size,
+                             const vector<SACKBlock> &sack_blocks) {
+    // an ACK that neither acknowledges new data nor updates the window, while data is outstanding, is a duplicate
+    const bool duplicate = unwrap(ackno, _isn, _next_seqno) == _ackno && window_size == _window_size &&
+                           !_segments_outstanding.empty();
     // evaluate window size 
     _window_size = window_size;
     // ignore impossible ackno (beyond next seqno) 
     if (unwrap(ackno, _isn, _next_seqno) > _next_seqno)
         return;
+    if (_sack)
+        _update_scoreboard(sack_blocks);
+    if (duplicate)
+        _duplicate_ack_received();
     // if ackno is greater than any previous ackno
     if (unwrap(ackno, _isn, _next_seqno) > _ackno) {
         // remove any that have now been fully acknowledged outstanding segments
+        const uint64_t acked_bytes = unwrap(ackno, _isn, _next_seqno) - _ackno;
         _ackno = unwrap(ackno, _isn, _next_seqno);
+        _duplicate_acks = 0;
 
         // remove any fully acked outstanding segments
-        _remove_acked_outstanding_segments();
+        const optional<uint64_t> rtt = _remove_acked_outstanding_segments();
+        if (rtt)
+            _rtt_estimator.add_sample(*rtt);
+        // during recovery, an ACK short of `_recover` means the next segment was lost as well
+        const bool partial_ack = (_in_fast_recovery || _in_timeout_recovery) && _ackno < _recover;
+        if (_in_fast_recovery && !partial_ack) {
+            _in_fast_recovery = false;
+            if (_congestion_controller)
+                _congestion_controller->on_recovery_end(bytes_in_flight());
+        }
+        _in_timeout_recovery = _in_timeout_recovery && partial_ack;
+        // let the congestion controller grow its window before filling it
+        if (_congestion_controller)
+            _congestion_controller->on_ack(
+                {acked_bytes, bytes_in_flight(), _time_ms, rtt, _in_fast_recovery && partial_ack});
+        // with SACK, skip over what the receiver already holds and what was already resent
+        if (partial_ack && _sack && _highest_sacked > _ackno)
+            _retransmit_next_hole();
+        else if (partial_ack)
+            _retransmit_earliest_segment();
         // fill the window again if new space has opened up
         fill_window();
-        // set the RTO back to its initial value
-        _retransmission_timer.reset_rto(_initial_retransmission_timeout);
-        // if the sender has any outstanding data, restart the retransmission timer
+        // set the RTO back to its initial value, or to the new estimate; an adaptive RTO stays backed off
+        // until a segment that wasn't retransmitted is timed (Karn's algorithm)
+        if (!_adaptive_rto || rtt)
+            _retransmission_timer.reset_rto(_fresh_rto());
+        // if the sender has any outstanding data, restart the retransmission timer, otherwise turn it off
         if (!_segments_outstanding.empty())
-            _retransmission_timer.start(_initial_retransmission_timeout);
+            _retransmission_timer.start(_retransmission_timer.get_rto());
+        else
+            _retransmission_timer.stop();
         // reset the count of `consecutive retransmissions` back to zero
         _count_consecutive_retransmissions = 0;
     };
@@ -135,27 +341,31 @@ void TCPSender::ack_received(const WrappingInt32 ackno, const uint16_t window_si
 //! \param[in] ms_since_last_tick the number of milliseconds since the last call to this method
 void TCPSender::tick(const size_t ms_since_last_tick) {
     // retransmit the earliest segment that hasn't been fully ack by the TCP receiver
+    _time_ms += ms_since_last_tick;
     _retransmission_timer.add(ms_since_last_tick);
     if (_retransmission_timer.is_expired()) {
-        // find the earliest (lowest sequence number) segment and resend it
-        if (!_segments_outstanding.empty()) {
-            uint64_t lsn = UINT64_MAX;
-            TCPSegment earliest_segment;
-            for (const TCPSegment& tcp_segment : _segments_outstanding) {
-                uint64_t seqno = unwrap(tcp_segment.header().seqno, _isn, _next_seqno);
-                if (seqno < lsn) {
-                    lsn = seqno;
-                    earliest_segment = tcp_segment;
-                };
-            };
-            _segments_out.push(earliest_segment);
-        };
+        // whatever was resent before the timeout may have been lost again, so each hole may be resent once more
+        for (OutstandingSegment &outstanding : _segments_outstanding)
+            outstanding.resent = false;
+        // resend the earliest (lowest sequence number) segment, which is at the front of the queue
+        _retransmit_earliest_segment();
+        // a timeout ends fast recovery, and duplicates of what was sent so far can't start another one;
+        // with fast retransmit, the ACKs for the retransmission will go on to resend the rest of what was lost
+        _in_fast_recovery = false;
+        _in_timeout_recovery = _fast_retransmit;
+        _duplicate_acks = 0;
+        _recover = _next_seqno;
         // If the window size is nonzero,
         if (_window_size > 0) {
+            // a timeout is a sign of heavy congestion
+            if (_congestion_controller)
+                _congestion_controller->on_timeout(bytes_in_flight(), _time_ms);
             // increment the number of consecutive retransmissions, this will be used by TCPConnection
             _count_consecutive_retransmissions++;
             // double the value of RTO
             _retransmission_timer.double_rto();
+            if (_adaptive_rto)
+                _retransmission_timer.reset_rto(min(_retransmission_timer.get_rto(), _rto_max));
         };
         // reset the retransmission timer and start it
         _retransmission_timer.start(_retransmission_timer.get_rto());
@@ -3,10 +3,15 @@
 
 #include "byte_stream.hh"
 #include "tcp_config.hh"
+#include "tcp_congestion_control.hh"
 #include "tcp_segment.hh"
+#include "timer_wheel.hh"
 #include "wrapping_integers.hh"
 
+#include <deque>
 #include <functional>
+#include <memory>
+#include <optional>
 #include <queue>
 #include <vector>
 
@@ -24,9 +29,35 @@ class TCPTimer {
     //! retransmission timer for the connection currently
     size_t _current_retransmission_timeout;
 
+    //! the wheel on which to arm a timer while this one is running, if any (see set_wheel())
+    TimerWheel *_wheel{nullptr};
+
+    //! called when the wheel's timer fires
+    TimerWheel::CallbackT _on_expiry{};
+
+    //! the timer armed on the wheel, if any
+    std::optional<TimerWheel::TimerId> _wheel_timer{};
+
+    //! arm a timer on the wheel for when this one expires, if it's running, in place of any armed before
+    void _rearm();
+
   public:
     TCPTimer(size_t initial_retransmission_timeout) : _is_running{false}, _ms_since_started{0}, _current_retransmission_timeout{initial_retransmission_timeout} {};
 
+    //! \brief Arm a timer on `wheel` for whenever this timer would expire, which calls `on_expiry`
+    //! \details Instead of polling is_expired() after every add(), the owner hears when the time is up. The wheel's
+    //! clock has to run at the same rate as the time passed to add().
+    void set_wheel(TimerWheel &wheel, const TimerWheel::CallbackT &on_expiry);
+
+    //! \name A TCPTimer can be moved but not copied, since it may own a timer on a wheel
+    //!@{
+    TCPTimer(TCPTimer &&other) noexcept;
+    TCPTimer &operator=(TCPTimer &&other) noexcept;
+    TCPTimer(const TCPTimer &other) = delete;
+    TCPTimer &operator=(const TCPTimer &other) = delete;
+    ~TCPTimer();
+    //!@}
+
     bool is_running() const {
       return _is_running;
     };
@@ -35,14 +66,17 @@ class TCPTimer {
       _is_running = true;
       _ms_since_started = 0;
       _current_retransmission_timeout = initial_retransmission_timeout;
+      _rearm();
     };
 
     void restart() {
       _ms_since_started = 0;
+      _rearm();
     };
 
     void stop() {
       _is_running = false;
+      _rearm();
     };
 
     void add(size_t ms_since_last_tick) {
@@ -55,10 +89,12 @@ class TCPTimer {
 
     void double_rto() {
       _current_retransmission_timeout <<= 1;
+      _rearm();
     };
 
     void reset_rto(size_t initial_retransmission_timeout) {
       _current_retransmission_timeout = initial_retransmission_timeout;
+      _rearm();
     };
 
     size_t get_rto() const {
@@ -66,6 +102,27 @@ class TCPTimer {
     };
 };
 
+//! Round-trip time estimator of [RFC 6298](\ref rfc::rfc6298)
+class RTTEstimator {
+  private:
+    //! smoothed round-trip time in milliseconds, once there has been a measurement
+    std::optional<double> _srtt{};
+
+    //! round-trip time variation in milliseconds
+    double _rttvar{0};
+
+  public:
+    //! \brief Take a new round-trip time measurement into account
+    void add_sample(const uint64_t rtt_ms);
+
+    //! \brief The smoothed round-trip time in milliseconds, if there has been a measurement
+    std::optional<double> srtt() const { return _srtt; }
+
+    //! \brief The retransmission timeout SRTT + max(G, 4 * RTTVAR), for a clock granularity G of 1 ms,
+    //! if there has been a measurement
+    std::optional<size_t> rto() const;
+};
+
 //! Accepts a ByteStream, divides it up into segments and sends the
 //! segments, keeps track of which segments are still in-flight,
 //! maintains the Retransmission Timer, and retransmits in-flight
@@ -78,8 +135,18 @@ class TCPSender {
     //! outbound queue of segments that the TCPSender wants sent
     std::queue<TCPSegment> _segments_out{};
 
-    //! outbound queue of segments that the TCPSerder wants to resend
-    std::vector<TCPSegment> _segments_outstanding{};
+    //! a segment that has been sent but not fully acknowledged
+    struct OutstandingSegment {
+        TCPSegment segment;  //!< the segment as it was sent
+        uint64_t seqno;      //!< the (absolute) sequence number of the segment
+        uint64_t sent_ms;    //!< when the segment was last sent, in milliseconds since the sender started
+        bool retransmitted;  //!< whether the segment has been sent more than once
+        bool sacked;         //!< whether a SACK block has reported the whole segment as received
+        bool resent;         //!< whether the segment has been sent again since the last timeout
+    };
+
+    //! segments that have been sent but not fully acknowledged, in sequence-number order
+    std::deque<OutstandingSegment> _segments_outstanding{};
 
     //! retransmission timer for the connection
     unsigned int _initial_retransmission_timeout;
@@ -96,11 +163,23 @@ class TCPSender {
     //! the retransmission timer
     TCPTimer _retransmission_timer;
 
+    //! estimates the round-trip time from segments that were acknowledged without being retransmitted
+    RTTEstimator _rtt_estimator{};
+
+    //! whether the RTO follows the round-trip time estimate (see TCPConfig::adaptive_rto)
+    bool _adaptive_rto{false};
+
+    //! lower bound on the estimated RTO, in milliseconds
+    size_t _rto_min{TCPConfig::RTO_MIN_DFLT};
+
+    //! upper bound on the (backed-off) adaptive RTO, in milliseconds
+    size_t _rto_max{TCPConfig::RTO_MAX_DFLT};
+
     //! the number of consecutive retransmissions
     unsigned int _count_consecutive_retransmissions{0};
 
-    //! the window size, init with 1
-    unsigned int _window_size{1};
+    //! the receiver's window size in bytes (after window scaling), init with 1
+    size_t _window_size{1};
 
     //! indicate whether already send SYN, make it true after sending the segment with SYN
     bool _syn_sent{false};
@@ -108,11 +187,57 @@ class TCPSender {
     //! indicate whether already send FIN, make it true after sending the segment with FIN
     bool _fin_sent{false};
 
-    //! remove any that have now been fully acknowledged outstanding segments
-    void _remove_acked_outstanding_segments();
+    //! the congestion controller, or null if only the receiver's window limits the bytes in flight
+    std::unique_ptr<CongestionController> _congestion_controller{};
+
+    //! milliseconds since the sender started, advanced by tick()
+    uint64_t _time_ms{0};
+
+    //! whether duplicate ACKs trigger a fast retransmit (see TCPConfig::fast_retransmit)
+    bool _fast_retransmit{false};
+
+    //! the number of duplicate ACKs since the ackno last advanced
+    unsigned int _duplicate_acks{0};
+
+    //! whether the sender is in fast recovery, retransmitting one hole per ACK
+    bool _in_fast_recovery{false};
+
+    //! whether the sender is retransmitting, one per ACK, the segments that were outstanding when the timer expired
+    bool _in_timeout_recovery{false};
+
+    //! the (absolute) next seqno when fast recovery began or the timer last expired;
+    //! recovery ends once it is acknowledged, and no new recovery begins before then
+    uint64_t _recover{0};
+
+    //! whether SACK was offered on the SYN, so that SACK blocks drive retransmission (see TCPConfig::sack)
+    bool _sack{false};
+
+    //! the window-scale shift count to offer on the SYN, if window scaling is enabled (see TCPConfig::window_scaling)
+    std::optional<uint8_t> _window_scale{};
+
+    //! the (absolute) sequence number just past the highest SACKed byte; outstanding data below it
+    //! that isn't SACKed is a hole
+    uint64_t _highest_sacked{0};
+
+    //! the RTO to (re)start the timer with after new data is acknowledged
+    size_t _fresh_rto() const;
 
-    //! get the char indexed at the first byte of the segment which contains _ackno, used for fill_window when window_size is zero
-    char _get_char_indexed_ackno() const;
+    //! send the earliest outstanding segment again
+    void _retransmit_earliest_segment();
+
+    //! send the earliest hole again, unless it has already been resent since the last timeout
+    //! \returns `true` if a segment was sent
+    bool _retransmit_next_hole();
+
+    //! mark the outstanding segments that the SACK blocks cover
+    void _update_scoreboard(const std::vector<SACKBlock> &sack_blocks);
+
+    //! count a duplicate ACK, and start or continue fast recovery
+    void _duplicate_ack_received();
+
+    //! remove any that have now been fully acknowledged outstanding segments
+    //! \returns the round-trip time of the newest removed segment, unless it was retransmitted (Karn's algorithm)
+    std::optional<uint64_t> _remove_acked_outstanding_segments();
 
   public:
     //! Initialize a TCPSender
@@ -120,6 +245,10 @@ class TCPSender {
               const uint16_t retx_timeout = TCPConfig::TIMEOUT_DFLT,
               const std::optional<WrappingInt32> fixed_isn = {});
 
+    //! Initialize a TCPSender from the sender capacity, timeout, ISN, congestion control and loss recovery
+    //! options in a TCPConfig
+    explicit TCPSender(const TCPConfig &config);
+
     //! \name "Input" interface for the writer
     //!@{
     ByteStream &stream_in() { return _stream; }
@@ -129,8 +258,11 @@ class TCPSender {
     //! \name Methods that can cause the TCPSender to send a segment
     //!@{
 
-    //! \brief A new acknowledgment was received
-    void ack_received(const WrappingInt32 ackno, const uint16_t window_size);
+    //! \brief A new acknowledgment was received, with any SACK blocks that it carried
+    //! \note `window_size` is in bytes, so a window field must be scaled first (see TCPReceiver::peer_window())
+    void ack_received(const WrappingInt32 ackno,
+                      const size_t window_size,
+                      const std::vector<SACKBlock> &sack_blocks = {});
 
     //! \brief Generate an empty-payload segment (useful for creating empty ACK segments)
     void send_empty_segment();
@@ -142,6 +274,14 @@ class TCPSender {
     void tick(const size_t ms_since_last_tick);
     //!@}
 
+    //! \brief Have the retransmission timer arm a timer on `wheel`, which calls `on_timeout` when it expires
+    //! \details The owner then calls tick() with the time since its last tick, and doesn't have to tick every
+    //! sender in between just to find out if its timer has expired. (The time also goes into round-trip time
+    //! measurements, so a sender should still be ticked before it is given an ACK.)
+    void set_timer_wheel(TimerWheel &wheel, const std::function<void()> &on_timeout) {
+        _retransmission_timer.set_wheel(wheel, on_timeout);
+    }
+
     //! \name Accessors
     //!@{
 
@@ -153,11 +293,20 @@ class TCPSender {
     //! \brief Number of consecutive retransmissions that have occurred in a row
     unsigned int consecutive_retransmissions() const;
 
+    //! \brief The smoothed round-trip time in milliseconds, once a segment has been timed
+    std::optional<double> srtt() const { return _rtt_estimator.srtt(); }
+
+    //! \brief The current retransmission timeout in milliseconds, including any exponential backoff
+    size_t retransmission_timeout() const { return _retransmission_timer.get_rto(); }
+
     //! \brief TCPSegments that the TCPSender has enqueued for transmission.
     //! \note These must be dequeued and sent by the TCPConnection,
     //! which will need to fill in the fields that are set by the TCPReceiver
     //! (ackno and window size) before sending.
     std::queue<TCPSegment> &segments_out() { return _segments_out; }
+
+    //! \brief The congestion controller chosen in the TCPConfig, or null if there is none
+    const CongestionController *congestion_controller() const { return _congestion_controller.get(); }
     //!@}
 
     //! \name What is the next sequence number? (used for testing)
@@ -7,8 +7,20 @@ void Buffer::remove_prefix(const size_t n) {
         throw out_of_range("Buffer::remove_prefix");
     }
     _starting_offset += n;
-    if (_storage and _starting_offset == _storage->size()) {
+    if (_starting_offset == _ending_offset) {
         _storage.reset();
+        _packet = {};
+    }
+}
+
+void Buffer::remove_suffix(const size_t n) {
+    if (n > str().size()) {
+        throw out_of_range("Buffer::remove_suffix");
+    }
+    _ending_offset -= n;
+    if (_starting_offset == _ending_offset) {
+        _storage.reset();
+        _packet = {};
     }
 }
 
@@ -31,6 +43,18 @@ BufferList::operator Buffer() const {
     }
 }
 
+Buffer BufferList::contiguous() const {
+    if (_buffers.size() <= 1) {
+        return *this;
+    }
+    PacketBuffer ret{size()};
+    char *out = ret.data();
+    for (const auto &buf : _buffers) {
+        out += buf.str().copy(out, buf.size());
+    }
+    return ret;
+}
+
 string BufferList::concatenate() const {
     std::string ret;
     ret.reserve(size());
@@ -66,7 +90,7 @@ void BufferList::remove_prefix(size_t n) {
 
 BufferViewList::BufferViewList(const BufferList &buffers) {
     for (const auto &x : buffers.buffers()) {
-        _views.push_back(x);
+        _views.push_back({const_cast<char *>(x.str().data()), x.size()});
     }
 }
 
@@ -76,11 +100,12 @@ void BufferViewList::remove_prefix(size_t n) {
             throw std::out_of_range("BufferListView::remove_prefix");
         }
 
-        if (n < _views.front().size()) {
-            _views.front().remove_prefix(n);
+        if (n < _views.front().iov_len) {
+            _views.front().iov_base = static_cast<char *>(_views.front().iov_base) + n;
+            _views.front().iov_len -= n;
             n = 0;
         } else {
-            n -= _views.front().size();
+            n -= _views.front().iov_len;
             _views.pop_front();
         }
     }
@@ -88,17 +113,8 @@ void BufferViewList::remove_prefix(size_t n) {
 
 size_t BufferViewList::size() const {
     size_t ret = 0;
-    for (const auto &buf : _views) {
-        ret += buf.size();
-    }
-    return ret;
-}
-
-vector<iovec> BufferViewList::as_iovecs() const {
-    vector<iovec> ret;
-    ret.reserve(_views.size());
-    for (const auto &x : _views) {
-        ret.push_back({const_cast<char *>(x.data()), x.size()});
+    for (const auto &view : _views) {
+        ret += view.iov_len;
     }
     return ret;
 }
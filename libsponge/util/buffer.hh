@@ -1,8 +1,10 @@
 #ifndef SPONGE_LIBSPONGE_BUFFER_HH
 #define SPONGE_LIBSPONGE_BUFFER_HH
 
+#include "packet_buffer.hh"
+#include "small_vector.hh"
+
 #include <algorithm>
-#include <deque>
 #include <memory>
 #include <numeric>
 #include <stdexcept>
@@ -15,21 +17,30 @@
 class Buffer {
   private:
     std::shared_ptr<std::string> _storage{};
+    PacketBuffer _packet{};  //!< Pooled storage, used instead of `_storage` when it is set
     size_t _starting_offset{};
+    size_t _ending_offset{};
 
   public:
     Buffer() = default;
 
     //! \brief Construct by taking ownership of a string
-    Buffer(std::string &&str) noexcept : _storage(std::make_shared<std::string>(std::move(str))) {}
+    Buffer(std::string &&str) noexcept
+        : _storage(std::make_shared<std::string>(std::move(str))), _ending_offset(_storage->size()) {}
+
+    //! \brief Construct by taking a reference to a pooled PacketBuffer (does not allocate)
+    Buffer(PacketBuffer packet) noexcept : _packet(std::move(packet)), _ending_offset(_packet.size()) {}
 
     //! \name Expose contents as a std::string_view
     //!@{
     std::string_view str() const {
+        if (_packet) {
+            return {_packet.data() + _starting_offset, _ending_offset - _starting_offset};
+        }
         if (not _storage) {
             return {};
         }
-        return {_storage->data() + _starting_offset, _storage->size() - _starting_offset};
+        return {_storage->data() + _starting_offset, _ending_offset - _starting_offset};
     }
 
     operator std::string_view() const { return str(); }
@@ -47,6 +58,10 @@ class Buffer {
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
     void remove_prefix(const size_t n);
+
+    //! \brief Discard the last `n` bytes of the string (does not require a copy or move)
+    //! \note Doesn't free any memory until the whole string has been discarded in all copies of the Buffer.
+    void remove_suffix(const size_t n);
 };
 
 //! \brief A reference-counted discontiguous string that can discard bytes from the front
@@ -55,8 +70,12 @@ class Buffer {
 //! encapsulate a TCP payload in a TCPSegment, and then encapsulate
 //! the TCPSegment in an IPv4Datagram) without copying the payload.
 class BufferList {
+  public:
+    //! Pieces that a BufferList holds without allocating, e.g. headers plus a payload
+    static constexpr size_t INLINE_BUFFERS = 4;
+
   private:
-    std::deque<Buffer> _buffers{};
+    SmallVector<Buffer, INLINE_BUFFERS> _buffers{};
 
   public:
     //! \name Constructors
@@ -65,7 +84,7 @@ class BufferList {
     BufferList() = default;
 
     //! \brief Construct from a Buffer
-    BufferList(Buffer buffer) : _buffers{buffer} {}
+    BufferList(Buffer buffer) { _buffers.push_back(std::move(buffer)); }
 
     //! \brief Construct by taking ownership of a std::string
     BufferList(std::string &&str) noexcept {
@@ -75,7 +94,7 @@ class BufferList {
     //!@}
 
     //! \brief Access the underlying queue of Buffers
-    const std::deque<Buffer> &buffers() const { return _buffers; }
+    const SmallVector<Buffer, INLINE_BUFFERS> &buffers() const { return _buffers; }
 
     //! \brief Append a BufferList
     void append(const BufferList &other);
@@ -84,6 +103,9 @@ class BufferList {
     //! \note Throws an exception unless BufferList is contiguous
     operator Buffer() const;
 
+    //! \brief Combine into one Buffer, copying into a pooled PacketBuffer only if there is more than one
+    Buffer contiguous() const;
+
     //! \brief Discard the first `n` bytes of the string (does not require a copy or move)
     void remove_prefix(size_t n);
 
@@ -96,7 +118,15 @@ class BufferList {
 
 //! \brief A non-owning temporary view (similar to std::string_view) of a discontiguous string
 class BufferViewList {
-    std::deque<std::string_view> _views{};
+  public:
+    //! Pieces that a BufferViewList holds without allocating
+    static constexpr size_t INLINE_VIEWS = 8;
+
+    //! The views, kept as the `iovec`s that system calls take
+    using IOVecs = SmallVector<iovec, INLINE_VIEWS>;
+
+  private:
+    IOVecs _views{};
 
   public:
     //! \name Constructors
@@ -121,10 +151,10 @@ class BufferViewList {
     //! \brief Size of the string
     size_t size() const;
 
-    //! \brief Convert to a vector of `iovec` structures
+    //! \brief The views as `iovec` structures, as they are kept (no copy or allocation)
     //! \note used for system calls that write discontiguous buffers,
     //! e.g. [writev(2)](\ref man2::writev) and [sendmsg(2)](\ref man2::sendmsg)
-    std::vector<iovec> as_iovecs() const;
+    const IOVecs &as_iovecs() const { return _views; }
 };
 
 #endif  // SPONGE_LIBSPONGE_BUFFER_HH
@@ -2,7 +2,11 @@
 
 #include "util.hh"
 
+#include <algorithm>
 #include <cerrno>
+#include <chrono>
+#include <climits>
+#include <iterator>
 #include <stdexcept>
 #include <system_error>
 #include <utility>
@@ -10,6 +14,19 @@
 
 using namespace std;
 
+//! \param[in] backend is how to wait for file descriptors to become ready
+EventLoop::EventLoop(const Backend backend) {
+    if (backend == Backend::IoUring and IoUring::available()) {
+        _uring.emplace();
+    } else if (backend != Backend::Poll) {
+        _epoll.emplace(SystemCall("epoll_create1", epoll_create1(EPOLL_CLOEXEC)));
+    }
+}
+
+EventLoop::Backend EventLoop::backend() const {
+    return _uring ? Backend::IoUring : _epoll ? Backend::Epoll : Backend::Poll;
+}
+
 unsigned int EventLoop::Rule::service_count() const {
     return direction == Direction::In ? fd.read_count() : fd.write_count();
 }
@@ -25,7 +42,131 @@ void EventLoop::add_rule(const FileDescriptor &fd,
                          const CallbackT &callback,
                          const InterestT &interest,
                          const CallbackT &cancel) {
-    _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+    if (backend() == Backend::Poll) {
+        _rules.push_back({fd.duplicate(), direction, callback, interest, cancel});
+        return;
+    }
+
+    // a closed fd's number can be reused, so any rules that are still registered under it are stale
+    auto &registration = _registrations[fd.fd_num()];
+    for (size_t i = 0; i < registration.rules.size();) {
+        if (registration.rules[i]->fd.closed()) {
+            _cancel(registration.rules[i]);
+            _forget(registration);
+        } else {
+            i++;
+        }
+    }
+
+    const auto target = interest.target<bool (*)()>();
+    const bool watched = not target or *target != always_interested;
+    const auto rule = _rules.insert(_rules.end(), {fd.duplicate(), direction, callback, interest, cancel, watched});
+    registration.rules.push_back(rule);
+    if (watched) {
+        _watched.push_back(rule);
+    } else {
+        _set_interest(*rule, true);
+    }
+}
+
+void EventLoop::_set_interest(Rule &rule, const bool interested) {
+    if (rule.interested == interested) {
+        return;
+    }
+    rule.interested = interested;
+    if (interested) {
+        _interested_rules++;
+    } else {
+        _interested_rules--;
+    }
+    _dirty.push_back(rule.fd.fd_num());
+}
+
+void EventLoop::_cancel(const RuleIterator rule) {
+    rule->cancel();
+    _set_interest(*rule, false);
+
+    auto &rules = _registrations.at(rule->fd.fd_num()).rules;
+    rules.erase(find(rules.begin(), rules.end(), rule));
+    if (rule->watched) {
+        _watched.erase(find(_watched.begin(), _watched.end(), rule));
+    }
+    _dirty.push_back(rule->fd.fd_num());
+
+    // the rule may hold the last reference to its fd (e.g. in its callback), so it has to stay until the fd is out
+    // of the epoll set
+    _canceled.splice(_canceled.end(), _rules, rule);
+}
+
+void EventLoop::_forget(Registration &registration) {
+    // a closed fd has already left the epoll set, but an io_uring poll holds on to the file until it's canceled
+    if (registration.poll) {
+        _uring->cancel_poll(*registration.poll);
+        registration.poll.reset();
+    }
+    registration.events = 0;
+}
+
+void EventLoop::_update_registrations() {
+    for (const int fd_num : _dirty) {
+        const auto registration = _registrations.find(fd_num);
+        if (registration == _registrations.end()) {
+            continue;
+        }
+
+        uint32_t events = 0;
+        bool closed = false;
+        for (const auto &rule : registration->second.rules) {
+            if (rule->interested) {
+                events |= rule->direction == Direction::In ? EPOLLIN : EPOLLOUT;
+            }
+            closed |= rule->fd.closed();
+        }
+
+        // an uninterested fd is taken out of the epoll set (or not polled), so that a hangup on it doesn't wake
+        // every wait
+        if (closed) {
+            _forget(registration->second);
+            events = 0;
+        }
+        if (events != registration->second.events and _uring) {
+            if (registration->second.poll) {
+                _uring->cancel_poll(*registration->second.poll);
+                registration->second.poll.reset();
+            }
+            if (events != 0) {
+                registration->second.poll = _uring->poll(fd_num, events, fd_num);
+            }
+        } else if (events != registration->second.events) {
+            const uint32_t registered = registration->second.events;
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd_num;
+            const int op = registered == 0 ? EPOLL_CTL_ADD : events == 0 ? EPOLL_CTL_DEL : EPOLL_CTL_MOD;
+            SystemCall("epoll_ctl", epoll_ctl(_epoll->fd_num(), op, fd_num, &event));
+        }
+        registration->second.events = events;
+
+        if (registration->second.rules.empty()) {
+            _registrations.erase(registration);
+        }
+    }
+    _dirty.clear();
+    _canceled.clear();
+}
+
+uint64_t EventLoop::_clock_ms() const {
+    return chrono::duration_cast<chrono::milliseconds>(chrono::steady_clock::now() - _start).count();
+}
+
+void EventLoop::_advance_timers() { _timers_fired += _timers.advance(_clock_ms()); }
+
+//! \param[in] delay_ms is how long to wait before calling `callback`
+//! \param[in] callback is called from wait_next_event
+//! \returns an id with which to cancel the timer
+TimerWheel::TimerId EventLoop::add_timer(const uint64_t delay_ms, const CallbackT &callback) {
+    // the wheel's time may be a little behind, if this isn't called from a callback
+    return _timers.add(delay_ms + (_clock_ms() - _timers.now()), callback);
 }
 
 //! \param[in] timeout_ms is the timeout value passed to [poll(2)](\ref man2::poll); `wait_next_event`
@@ -49,6 +190,8 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! this function returns Result::Exit.
 //!
 //! If a timeout occurred while polling (i.e., no fd became ready), this function returns Result::Timeout.
+//! The wait ends early when the next timer from add_timer() may be due, and the timers that are due by then are
+//! fired (before any Rule::callback); if any fired, this function returns Result::Success instead of timing out.
 //!
 //! Otherwise, this function returns Result::Success.
 //!
@@ -59,6 +202,22 @@ void EventLoop::add_rule(const FileDescriptor &fd,
 //! will result in a busy loop (poll returns on a ready file descriptor; file descriptor is not read or
 //! written, so it is still ready; the next call to poll will immediately return).
 EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
+    // fire any timers that are already due, and then don't wait for long
+    _timers_fired = 0;
+    _advance_timers();
+    int wait_ms = _timers_fired > 0 ? 0 : timeout_ms;
+
+    // wake up in time for the next timer
+    if (const auto next_timer = _timers.next_expiry()) {
+        const int timer_ms = min<uint64_t>(*next_timer, INT_MAX);
+        wait_ms = wait_ms < 0 ? timer_ms : min(wait_ms, timer_ms);
+    }
+
+    const Result result = backend() == Backend::Poll ? _wait_poll(wait_ms) : _wait_registered(wait_ms);
+    return result == Result::Timeout and _timers_fired > 0 ? Result::Success : result;
+}
+
+EventLoop::Result EventLoop::_wait_poll(const int timeout_ms) {
     vector<pollfd> pollfds{};
     pollfds.reserve(_rules.size());
     bool something_to_poll = false;
@@ -89,13 +248,15 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
     }
 
     // quit if there is nothing left to poll
-    if (not something_to_poll) {
+    if (not something_to_poll and _timers.empty()) {
         return Result::Exit;
     }
 
     // call poll -- wait until one of the fds satisfies one of the rules (writeable/readable)
     try {
-        if (0 == SystemCall("poll", ::poll(pollfds.data(), pollfds.size(), timeout_ms))) {
+        const int ready = SystemCall("poll", ::poll(pollfds.data(), pollfds.size(), timeout_ms));
+        _advance_timers();
+        if (ready == 0) {
             return Result::Timeout;
         }
     } catch (unix_error const &e) {
@@ -143,3 +304,126 @@ EventLoop::Result EventLoop::wait_next_event(const int timeout_ms) {
 
     return Result::Success;
 }
+
+int EventLoop::_wait_ready(const int timeout_ms) {
+    if (_epoll) {
+        _ready.resize(max(_ready.size(), size_t(64)));
+        return SystemCall("epoll_wait", epoll_wait(_epoll->fd_num(), _ready.data(), _ready.size(), timeout_ms));
+    }
+
+    // one system call puts back the polls of the fds that were ready last time, and waits for the next ones
+    _ready.clear();
+    for (const auto &completion : _uring->submit(1, timeout_ms)) {
+        const int fd_num = completion.user_data;
+        auto &registration = _registrations.at(fd_num);
+        registration.poll.reset();
+        registration.events = 0;
+        _dirty.push_back(fd_num);
+
+        epoll_event event{};
+        event.events = completion.result < 0 ? uint32_t(EPOLLERR) : uint32_t(completion.result);
+        event.data.fd = fd_num;
+        _ready.push_back(event);
+    }
+    return _ready.size();
+}
+
+EventLoop::Result EventLoop::_wait_registered(const int timeout_ms) {
+    // ask the rules that have a say whether they are interested, and cancel the ones that are done
+    for (size_t i = 0; i < _watched.size();) {
+        const auto rule = _watched[i];
+        if ((rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed()) {
+            _cancel(rule);
+            continue;
+        }
+        _set_interest(*rule, rule->interest());
+        i++;
+    }
+    _update_registrations();
+
+    // quit if there is nothing left to wait for
+    if (_interested_rules == 0 and _timers.empty()) {
+        return Result::Exit;
+    }
+
+    // wait until one of the fds is ready
+    int ready = 0;
+    try {
+        ready = _wait_ready(timeout_ms);
+    } catch (unix_error const &e) {
+        if (e.code().value() == EINTR) {
+            return Result::Exit;
+        }
+        throw;
+    }
+    _advance_timers();
+
+    if (ready == 0) {
+        // a quiet moment: look for rules whose fds were closed without them noticing
+        for (auto rule = _rules.begin(); rule != _rules.end();) {
+            const auto next = std::next(rule);
+            if (rule->fd.closed()) {
+                _cancel(rule);
+            }
+            rule = next;
+        }
+        _update_registrations();
+        return Result::Timeout;
+    }
+
+    // go through the ready fds, and the interested rules on each one
+    for (int i = 0; i < ready; i++) {
+        const int fd_num = _ready[i].data.fd;
+        const uint32_t revents = _ready[i].events;
+        if (revents & EPOLLERR) {
+            throw runtime_error("EventLoop: error on polled file descriptor");
+        }
+
+        // (only the rules that were there before the wait, even if callbacks add more)
+        auto registration = _registrations.find(fd_num);
+        size_t count = registration == _registrations.end() ? 0 : registration->second.rules.size();
+        for (size_t idx = 0; idx < count; idx++) {
+            registration = _registrations.find(fd_num);
+            if (registration == _registrations.end() or idx >= registration->second.rules.size()) {
+                break;
+            }
+            const auto rule = registration->second.rules[idx];
+            if (not rule->interested) {
+                continue;
+            }
+
+            const uint32_t wanted = rule->direction == Direction::In ? EPOLLIN : EPOLLOUT;
+            const bool ready_for_rule = revents & wanted;
+            const bool hup = revents & EPOLLHUP;
+            const bool done = (rule->direction == Direction::In and rule->fd.eof()) or rule->fd.closed();
+            if (done or (hup and not ready_for_rule)) {
+                // if the _only_ condition was a hangup, this FD is defunct (see _wait_poll)
+                _cancel(rule);
+                idx--;
+                count--;
+                continue;
+            }
+
+            if (ready_for_rule) {
+                const auto count_before = rule->service_count();
+                rule->callback();
+
+                // only check for busy wait if we're not canceling or exiting
+                if (count_before == rule->service_count() and rule->interest()) {
+                    throw runtime_error(
+                        "EventLoop: busy wait detected: callback did not read/write fd and is still interested");
+                }
+            }
+        }
+    }
+
+    // the next wait may bring more events at once
+    if (_epoll and size_t(ready) == _ready.size()) {
+        _ready.resize(2 * _ready.size());
+    }
+
+    // let go of the rules that were canceled
+    _update_registrations();
+
+    return Result::Success;
+}
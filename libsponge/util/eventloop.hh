@@ -2,11 +2,19 @@
 #define SPONGE_LIBSPONGE_EVENTLOOP_HH
 
 #include "file_descriptor.hh"
+#include "io_uring.hh"
+#include "timer_wheel.hh"
 
+#include <chrono>
+#include <cstdint>
 #include <cstdlib>
 #include <functional>
 #include <list>
+#include <optional>
 #include <poll.h>
+#include <sys/epoll.h>
+#include <unordered_map>
+#include <vector>
 
 //! Waits for events on file descriptors and executes corresponding callbacks.
 class EventLoop {
@@ -17,6 +25,21 @@ class EventLoop {
         Out = POLLOUT  //!< Callback will be triggered when Rule::fd is writable.
     };
 
+    //! How an EventLoop waits for its file descriptors.
+    enum class Backend {
+        Poll,    //!< Build the set of file descriptors afresh for each [poll(2)](\ref man2::poll).
+        Epoll,   //!< Keep the file descriptors registered with [epoll(7)](\ref man7::epoll) between waits.
+        IoUring  //!< Keep polls of the file descriptors in flight on an [io_uring(7)](\ref man7::io_uring), or use
+                 //!< Backend::Epoll if io_uring isn't available.
+    };
+
+    //! Returned by each call to EventLoop::wait_next_event.
+    enum class Result {
+        Success,  //!< At least one Rule was triggered.
+        Timeout,  //!< No rules were triggered before timeout.
+        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
+    };
+
   private:
     using CallbackT = std::function<void(void)>;  //!< Callback for ready Rule::fd
     using InterestT = std::function<bool(void)>;  //!< `true` return indicates Rule::fd should be polled.
@@ -30,30 +53,99 @@ class EventLoop {
         CallbackT callback;   //!< A callback that reads or writes fd.
         InterestT interest;   //!< A callback that returns `true` whenever fd should be polled.
         CallbackT cancel;     //!< A callback that is called when the rule is cancelled (e.g. on hangup)
+        bool watched{};       //!< Whether Rule::interest has to be asked before each wait (not Backend::Poll).
+        bool interested{};    //!< What Rule::interest said last time it was asked (not Backend::Poll).
 
         //! Returns the number of times fd has been read or written, depending on the value of Rule::direction.
         //! \details This function is used internally by EventLoop; you will not need to call it
         unsigned int service_count() const;
     };
 
+    using RuleIterator = std::list<Rule>::iterator;
+
+    //! The rules for one file descriptor, which is registered with epoll (or polled by io_uring) once for them all.
+    struct Registration {
+        std::vector<RuleIterator> rules{};  //!< The rules on this file descriptor, in the order they were added.
+        uint32_t events{};                  //!< The events the file descriptor is registered for, if any.
+        std::optional<uint64_t> poll{};     //!< The io_uring poll in flight for `events` (Backend::IoUring only).
+    };
+
     std::list<Rule> _rules{};  //!< All rules that have been added and not canceled.
 
+    TimerWheel _timers{};  //!< Timers added by add_timer(), on a clock that starts at `_start`.
+    std::chrono::steady_clock::time_point _start{std::chrono::steady_clock::now()};
+    size_t _timers_fired{};  //!< Timers fired during the current wait_next_event.
+
+    //! Milliseconds since the EventLoop was created.
+    uint64_t _clock_ms() const;
+
+    //! Bring the timers up to the present, firing the ones that are due.
+    void _advance_timers();
+
+    //! \name State of Backend::Epoll and Backend::IoUring
+    //!@{
+    std::optional<FileDescriptor> _epoll{};                   //!< The epoll instance (Backend::Epoll).
+    std::optional<::IoUring> _uring{};                        //!< The io_uring instance (Backend::IoUring).
+    std::unordered_map<int, Registration> _registrations{};  //!< Rules by file descriptor number.
+    std::vector<RuleIterator> _watched{};                     //!< Rules with a Rule::interest to ask before each wait.
+    std::list<Rule> _canceled{};                              //!< Canceled rules, kept until their fds are updated.
+    std::vector<int> _dirty{};                                //!< File descriptors whose events may have to change.
+    std::vector<epoll_event> _ready{};                        //!< Filled in by epoll_wait or from io_uring.
+    size_t _interested_rules{};                               //!< Number of rules that are interested.
+    //!@}
+
+    //! Whether `interest` is the default, which is always interested and so never needs asking.
+    static bool always_interested() { return true; }
+
+    //! Record what a rule's interest is now, and mark its file descriptor for updating if that changed.
+    void _set_interest(Rule &rule, const bool interested);
+
+    //! Call a rule's cancel callback and remove it.
+    void _cancel(const RuleIterator rule);
+
+    //! Forget what a registration's file descriptor was registered for, after it was closed.
+    void _forget(Registration &registration);
+
+    //! Bring each dirty file descriptor's registration with epoll (or its io_uring poll) up to date.
+    void _update_registrations();
+
+    //! Wait for registered file descriptors to be ready, and put them in `_ready`.
+    int _wait_ready(const int timeout_ms);
+
+    //! wait_next_event with Backend::Poll.
+    Result _wait_poll(const int timeout_ms);
+
+    //! wait_next_event with Backend::Epoll or Backend::IoUring.
+    Result _wait_registered(const int timeout_ms);
+
   public:
-    //! Returned by each call to EventLoop::wait_next_event.
-    enum class Result {
-        Success,  //!< At least one Rule was triggered.
-        Timeout,  //!< No rules were triggered before timeout.
-        Exit  //!< All rules have been canceled or were uninterested; make no further calls to EventLoop::wait_next_event.
-    };
+    //! Use [poll(2)](\ref man2::poll), or the given backend, to wait for events.
+    explicit EventLoop(const Backend backend = Backend::Poll);
+
+    //! The backend in use, which is Backend::Epoll if Backend::IoUring was asked for but isn't available.
+    Backend backend() const;
 
     //! Add a rule whose callback will be called when `fd` is ready in the specified Direction.
     void add_rule(const FileDescriptor &fd,
                   const Direction direction,
                   const CallbackT &callback,
-                  const InterestT &interest = [] { return true; },
+                  const InterestT &interest = always_interested,
                   const CallbackT &cancel = [] {});
 
-    //! Calls [poll(2)](\ref man2::poll) and then executes callback for each ready fd.
+    //! \brief Call `callback` once, from wait_next_event, when `delay_ms` milliseconds from now have passed.
+    //! \details Timers are kept in a TimerWheel, so that adding, canceling and firing each take constant time.
+    TimerWheel::TimerId add_timer(const uint64_t delay_ms, const CallbackT &callback);
+
+    //! \brief Cancel a timer added by add_timer()
+    //! \returns `true` if the timer hadn't fired or been canceled already
+    bool cancel_timer(const TimerWheel::TimerId id) { return _timers.cancel(id); }
+
+    //! \brief The wheel that add_timer() uses, for code that arms its own timers (like TCPSender::set_timer_wheel)
+    //! \note The wheel's time is brought up to date when each wait ends, before any callback is called.
+    TimerWheel &timers() { return _timers; }
+
+    //! Calls [poll(2)](\ref man2::poll), [epoll_wait(2)](\ref man2::epoll_wait) or
+    //! [io_uring_enter(2)](\ref man2::io_uring_enter) and then executes callback for each ready fd.
     Result wait_next_event(const int timeout_ms);
 };
 
@@ -72,5 +164,22 @@ using Direction = EventLoop::Direction;
 //! A Rule installed using EventLoop::add_cancelable_rule will be polled and canceled under the
 //! same conditions, with the additional condition that if Rule::callback returns `true`, the
 //! Rule will be canceled.
+//!
+//! With Backend::Epoll, each file descriptor stays registered with epoll from one call to the next, and is only
+//! re-registered when the set of directions that its rules are interested in changes. Only rules whose `interest`
+//! is not the default are asked before each wait, and only the rules of ready file descriptors are visited after
+//! it, so an iteration costs time in proportion to the number of ready (and watched) rules rather than the total.
+//! One difference follows: a rule whose fd is closed other than from one of its callbacks is canceled at the next
+//! timeout, or when another rule is added for the same file descriptor number, rather than at the next wait.
+//!
+//! With Backend::IoUring, each interested file descriptor has a one-shot poll in flight on an io_uring. The polls
+//! of the file descriptors that were ready are put back (and the polls whose interest changed are replaced) in the
+//! same [io_uring_enter(2)](\ref man2::io_uring_enter) call that waits, so an iteration costs one system call
+//! however many file descriptors were ready. The iteration otherwise works as with Backend::Epoll. An io_uring poll
+//! keeps its file open, so a file descriptor that is closed other than from one of its own callbacks stays open
+//! (e.g. a socket's peer doesn't see it close) until its rules are canceled as above.
+//!
+//! With any backend, wait_next_event also wakes up in time for the next timer added with add_timer(), and the
+//! EventLoop keeps going (rather than returning Result::Exit) while any timer is armed.
 
 #endif  // SPONGE_LIBSPONGE_EVENTLOOP_HH
@@ -8,9 +8,13 @@
 #include <stdexcept>
 #include <sys/uio.h>
 #include <unistd.h>
+#include <vector>
 
 using namespace std;
 
+//! Maximum size of a read
+static constexpr size_t MAX_READ_SIZE = 1024 * 1024;
+
 //! \param[in] fd is the file descriptor number returned by [open(2)](\ref man2::open) or similar
 FileDescriptor::FDWrapper::FDWrapper(const int fd) : _fd(fd) {
     if (fd < 0) {
@@ -44,23 +48,47 @@ FileDescriptor::FileDescriptor(shared_ptr<FDWrapper> other_shared_ptr) : _intern
 //! \returns a copy of this FileDescriptor
 FileDescriptor FileDescriptor::duplicate() const { return FileDescriptor(_internal_fd); }
 
-//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
-//! \param[out] str is the string to be read
-void FileDescriptor::read(std::string &str, const size_t limit) {
-    constexpr size_t BUFFER_SIZE = 1024 * 1024;  // maximum size of a read
-    const size_t size_to_read = min(BUFFER_SIZE, limit);
-    str.resize(size_to_read);
-
-    ssize_t bytes_read = SystemCall("read", ::read(fd_num(), str.data(), size_to_read));
-    if (limit > 0 && bytes_read == 0) {
+optional<size_t> FileDescriptor::_try_read(char *data, const size_t size, const int errno_mask) {
+    const ssize_t bytes_read = SystemCall("read", ::read(fd_num(), data, size), errno_mask);
+    if (bytes_read < 0) {
+        return {};
+    }
+    if (size > 0 && bytes_read == 0) {
         _internal_fd->_eof = true;
     }
-    if (bytes_read > static_cast<ssize_t>(size_to_read)) {
+    if (bytes_read > static_cast<ssize_t>(size)) {
         throw runtime_error("read() read more than requested");
     }
-    str.resize(bytes_read);
 
     register_read();
+    return bytes_read;
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \param[out] str is the string to be read
+//! \details The read goes to a buffer that each thread allocates once and reuses, and then just the bytes read are
+//! copied to `str`, so a short read doesn't resize `str` to the largest possible read (and zero-fill it).
+void FileDescriptor::read(std::string &str, const size_t limit) {
+    static thread_local vector<char> buffer(MAX_READ_SIZE);
+
+    const size_t bytes_read = _read(buffer.data(), min(MAX_READ_SIZE, limit));
+    str.assign(buffer.data(), bytes_read);
+}
+
+//! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
+//! \returns the bytes read, in a pooled PacketBuffer
+Buffer FileDescriptor::read_buffer(const size_t limit) {
+    PacketBuffer buffer{min(MAX_READ_SIZE, limit)};
+    buffer.resize(_read(buffer.data(), buffer.size()));
+    buffer.shrink_to_fit();
+    return buffer;
+}
+
+//! \param[in] buffer is where to read to, which may be a PacketBuffer that the caller keeps reusing
+//! \returns the bytes read, in `buffer`
+Buffer FileDescriptor::read_buffer(PacketBuffer buffer) {
+    buffer.resize(_read(buffer.data(), buffer.capacity()));
+    return buffer;
 }
 
 //! \param[in] limit is the maximum number of bytes to read; fewer bytes may be returned
@@ -77,7 +105,7 @@ size_t FileDescriptor::write(BufferViewList buffer, const bool write_all) {
     size_t total_bytes_written = 0;
 
     do {
-        auto iovecs = buffer.as_iovecs();
+        const auto &iovecs = buffer.as_iovecs();
 
         const ssize_t bytes_written = SystemCall("writev", ::writev(fd_num(), iovecs.data(), iovecs.size()));
         if (bytes_written == 0 and buffer.size() != 0) {
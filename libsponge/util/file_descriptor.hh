@@ -7,6 +7,7 @@
 #include <cstddef>
 #include <limits>
 #include <memory>
+#include <optional>
 
 //! A reference-counted handle to a file descriptor
 class FileDescriptor {
@@ -44,10 +45,20 @@ class FileDescriptor {
     // private constructor used to duplicate the FileDescriptor (increase the reference count)
     explicit FileDescriptor(std::shared_ptr<FDWrapper> other_shared_ptr);
 
+    //! Read up to `size` bytes into `data`, noting EOF, and return the number read
+    size_t _read(char *data, const size_t size) { return *_try_read(data, size); }
+
   protected:
+    //! Read up to `size` bytes into `data`, noting EOF, and return the number read, or nothing if the read failed
+    //! with `errno_mask` (e.g. EAGAIN), which doesn't count as a read
+    std::optional<size_t> _try_read(char *data, const size_t size, const int errno_mask = 0);
+
     void register_read() { ++_internal_fd->_read_count; }    //!< increment read count
     void register_write() { ++_internal_fd->_write_count; }  //!< increment write count
 
+    //! IoUring reads and writes by itself, and keeps the counts and EOF flag up to date
+    friend class IoUring;
+
   public:
     //! Construct from a file descriptor number returned by the kernel
     explicit FileDescriptor(const int fd);
@@ -61,6 +72,13 @@ class FileDescriptor {
     //! Read up to `limit` bytes into `str` (caller can allocate storage)
     void read(std::string &str, const size_t limit = std::numeric_limits<size_t>::max());
 
+    //! \brief Read up to `limit` bytes into a pooled PacketBuffer, and return exactly the bytes read
+    //! \details Once the pool is warm, this doesn't allocate, and a short read doesn't hold on to `limit` bytes.
+    Buffer read_buffer(const size_t limit = PacketBuffer::MAX_POOLED_SIZE);
+
+    //! \brief Read into the caller's `buffer` (up to its capacity), and return exactly the bytes read
+    Buffer read_buffer(PacketBuffer buffer);
+
     //! Write a string, possibly blocking until all is written
     size_t write(const char *str, const bool write_all = true) { return write(BufferViewList(str), write_all); }
 
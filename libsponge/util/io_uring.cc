@@ -0,0 +1,336 @@
+#include "io_uring.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <limits>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+using namespace std;
+
+//! The user_data of the requests that cancel_poll() makes, whose results aren't returned
+static constexpr uint64_t POLL_REMOVE_USER_DATA = numeric_limits<uint64_t>::max();
+
+//! Most buffers that io_uring will register
+static constexpr size_t MAX_REGISTERED_BUFFERS = 16384;
+
+int IoUring::_setup(const unsigned entries, io_uring_params &params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+}
+
+//! \param[in] entries is the number of submission queue entries, which bounds how many operations go to the kernel
+//!                    with each system call (a power of two, up to 32768)
+//! \param[in] buffers is the number of buffers for read() and write(), and so how many of those can be in flight
+//! \param[in] buffer_size is the size of each buffer
+IoUring::IoUring(const unsigned entries, const size_t buffers, const size_t buffer_size)
+    : _ring(SystemCall("io_uring_setup", _setup(entries, _params))), _buffer_count(buffers), _buffer_size(buffer_size) {
+    constexpr uint32_t required_features = IORING_FEAT_SINGLE_MMAP | IORING_FEAT_NODROP | IORING_FEAT_EXT_ARG;
+    if ((_params.features & required_features) != required_features) {
+        throw runtime_error("IoUring: the kernel's io_uring lacks features this needs");
+    }
+    if (buffer_size > numeric_limits<uint32_t>::max()) {
+        throw runtime_error("IoUring: buffer size too large");
+    }
+
+    // the submission and completion rings share one mapping, and the submission queue entries have another
+    const size_t sq_size = _params.sq_off.array + _params.sq_entries * sizeof(unsigned);
+    const size_t cq_size = _params.cq_off.cqes + _params.cq_entries * sizeof(io_uring_cqe);
+    _ring_memory_size = max(sq_size, cq_size);
+    void *ring_memory = mmap(nullptr,
+                             _ring_memory_size,
+                             PROT_READ | PROT_WRITE,
+                             MAP_SHARED | MAP_POPULATE,
+                             _ring.fd_num(),
+                             IORING_OFF_SQ_RING);
+    if (ring_memory == MAP_FAILED) {
+        throw unix_error("mmap");
+    }
+    _ring_memory = ring_memory;
+
+    void *sqes = mmap(nullptr,
+                      _params.sq_entries * sizeof(io_uring_sqe),
+                      PROT_READ | PROT_WRITE,
+                      MAP_SHARED | MAP_POPULATE,
+                      _ring.fd_num(),
+                      IORING_OFF_SQES);
+    if (sqes == MAP_FAILED) {
+        const unix_error error("mmap");
+        munmap(_ring_memory, _ring_memory_size);
+        throw error;
+    }
+    _sqes = static_cast<io_uring_sqe *>(sqes);
+
+    char *const ring = static_cast<char *>(_ring_memory);
+    _sq_head = reinterpret_cast<const unsigned *>(ring + _params.sq_off.head);
+    _sq_tail = reinterpret_cast<unsigned *>(ring + _params.sq_off.tail);
+    _cq_head = reinterpret_cast<unsigned *>(ring + _params.cq_off.head);
+    _cq_tail = reinterpret_cast<const unsigned *>(ring + _params.cq_off.tail);
+    _cqes = reinterpret_cast<const io_uring_cqe *>(ring + _params.cq_off.cqes);
+
+    // submission queue entry i always goes in slot i of the submission ring
+    unsigned *const sq_array = reinterpret_cast<unsigned *>(ring + _params.sq_off.array);
+    for (unsigned i = 0; i < _params.sq_entries; i++) {
+        sq_array[i] = i;
+    }
+
+    if (buffers > 0) {
+        void *memory = mmap(nullptr, buffers * buffer_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (memory == MAP_FAILED) {
+            const unix_error error("mmap");
+            munmap(_sqes, _params.sq_entries * sizeof(io_uring_sqe));
+            munmap(_ring_memory, _ring_memory_size);
+            throw error;
+        }
+        _buffers = static_cast<char *>(memory);
+
+        vector<iovec> iovecs(buffers);
+        for (size_t i = 0; i < buffers; i++) {
+            iovecs[i] = {_buffers + i * buffer_size, buffer_size};
+            _free_buffers.push_back(buffers - 1 - i);
+        }
+        _registered_buffers =
+            buffers <= MAX_REGISTERED_BUFFERS and
+            syscall(__NR_io_uring_register, _ring.fd_num(), IORING_REGISTER_BUFFERS, iovecs.data(), buffers) == 0;
+    }
+}
+
+IoUring::~IoUring() {
+    // closing the ring cancels whatever is still in flight
+    try {
+        _ring.close();
+    } catch (const exception &e) {
+        cerr << "Exception destructing IoUring: " << e.what() << endl;
+    }
+    if (_buffers) {
+        munmap(_buffers, _buffer_count * _buffer_size);
+    }
+    munmap(_sqes, _params.sq_entries * sizeof(io_uring_sqe));
+    munmap(_ring_memory, _ring_memory_size);
+}
+
+//! \details Sets up (and tears down) a small ring the first time it's called.
+bool IoUring::available() {
+    static const bool available = [] {
+        try {
+            IoUring ring{2};
+            return true;
+        } catch (const exception &) {
+            return false;
+        }
+    }();
+    return available;
+}
+
+io_uring_sqe &IoUring::_next_sqe() {
+    if (*_sq_tail + _queued - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE) == _params.sq_entries) {
+        _enter(0, -1);
+    }
+    io_uring_sqe &sqe = _sqes[(*_sq_tail + _queued) & (_params.sq_entries - 1)];
+    sqe = {};
+    _queued++;
+    return sqe;
+}
+
+uint32_t IoUring::_new_op(const OpKind kind, const uint64_t user_data) {
+    uint32_t index = _ops.size();
+    if (_free_ops.empty()) {
+        _ops.emplace_back();
+    } else {
+        index = _free_ops.back();
+        _free_ops.pop_back();
+    }
+    _ops[index].kind = kind;
+    _ops[index].user_data = user_data;
+    _in_flight++;
+    return index;
+}
+
+//! \param[in] fd is the file descriptor to read from
+//! \param[in] user_data is returned with the Completion
+bool IoUring::read(const FileDescriptor &fd, const uint64_t user_data) {
+    if (_free_buffers.empty()) {
+        return false;
+    }
+    const uint32_t buffer = _free_buffers.back();
+    _free_buffers.pop_back();
+
+    const uint32_t index = _new_op(OpKind::Read, user_data);
+    _ops[index].buffer = buffer;
+    _ops[index].fd.emplace(fd.duplicate());
+
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = _registered_buffers ? IORING_OP_READ_FIXED : IORING_OP_READ;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(_buffers + buffer * _buffer_size);
+    sqe.len = _buffer_size;
+    sqe.off = numeric_limits<uint64_t>::max();  // from the file's current position, as read(2) does
+    sqe.buf_index = buffer;
+    sqe.user_data = index;
+    return true;
+}
+
+//! \param[in] fd is the file descriptor to write to
+//! \param[in] data is the data to write, which has been copied by the time this returns
+//! \param[in] user_data is returned with the Completion
+bool IoUring::write(const FileDescriptor &fd, const BufferViewList &data, const uint64_t user_data) {
+    if (data.size() > _buffer_size) {
+        throw runtime_error("IoUring: write larger than a buffer");
+    }
+    if (_free_buffers.empty()) {
+        return false;
+    }
+    const uint32_t buffer = _free_buffers.back();
+    _free_buffers.pop_back();
+
+    char *const start = _buffers + buffer * _buffer_size;
+    size_t length = 0;
+    for (const auto &view : data.as_iovecs()) {
+        memcpy(start + length, view.iov_base, view.iov_len);
+        length += view.iov_len;
+    }
+
+    const uint32_t index = _new_op(OpKind::Write, user_data);
+    _ops[index].buffer = buffer;
+    _ops[index].fd.emplace(fd.duplicate());
+
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = _registered_buffers ? IORING_OP_WRITE_FIXED : IORING_OP_WRITE;
+    sqe.fd = fd.fd_num();
+    sqe.addr = reinterpret_cast<uint64_t>(start);
+    sqe.len = length;
+    sqe.off = numeric_limits<uint64_t>::max();
+    sqe.buf_index = buffer;
+    sqe.user_data = index;
+    return true;
+}
+
+//! \param[in] fd_num is the file descriptor to poll, which the caller has to keep open until the poll is done
+//! \param[in] events are the events to poll for
+//! \param[in] user_data is returned with the Completion
+uint64_t IoUring::poll(const int fd_num, const uint32_t events, const uint64_t user_data) {
+    const uint32_t index = _new_op(OpKind::Poll, user_data);
+    const uint64_t handle = (uint64_t{_ops[index].generation} << 32) | index;
+
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_POLL_ADD;
+    sqe.fd = fd_num;
+    sqe.poll32_events = events;
+    sqe.user_data = handle;
+    return handle;
+}
+
+//! \param[in] handle is what poll() returned
+void IoUring::cancel_poll(const uint64_t handle) {
+    const uint32_t index = handle & 0xffffffff;
+    if (index >= _ops.size() or _ops[index].generation != handle >> 32 or _ops[index].kind != OpKind::Poll) {
+        return;
+    }
+    _ops[index].kind = OpKind::CanceledPoll;
+
+    io_uring_sqe &sqe = _next_sqe();
+    sqe.opcode = IORING_OP_POLL_REMOVE;
+    sqe.addr = handle;
+    sqe.user_data = POLL_REMOVE_USER_DATA;
+}
+
+void IoUring::_enter(const unsigned wait_for, const int timeout_ms) {
+    // (entries that an earlier call didn't get to, because one of them failed, are submitted again)
+    __atomic_store_n(_sq_tail, *_sq_tail + _queued, __ATOMIC_RELEASE);
+    _queued = 0;
+    const unsigned to_submit = *_sq_tail - __atomic_load_n(_sq_head, __ATOMIC_ACQUIRE);
+
+    unsigned flags = wait_for > 0 ? IORING_ENTER_GETEVENTS : 0;
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    if (wait_for > 0 and timeout_ms >= 0) {
+        timeout.tv_sec = timeout_ms / 1000;
+        timeout.tv_nsec = (timeout_ms % 1000) * 1000000LL;
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        flags |= IORING_ENTER_EXT_ARG;
+    }
+    if (to_submit == 0 and wait_for == 0) {
+        return;
+    }
+
+    void *const argp = flags & IORING_ENTER_EXT_ARG ? &arg : nullptr;
+    const size_t argsz = argp ? sizeof(arg) : 0;
+    // (ETIME just means that the timeout passed)
+    SystemCall("io_uring_enter",
+               static_cast<int>(syscall(__NR_io_uring_enter, _ring.fd_num(), to_submit, wait_for, flags, argp, argsz)),
+               ETIME);
+}
+
+void IoUring::_collect() {
+    unsigned head = *_cq_head;
+    const unsigned tail = __atomic_load_n(_cq_tail, __ATOMIC_ACQUIRE);
+    for (; head != tail; head++) {
+        const io_uring_cqe &cqe = _cqes[head & (_params.cq_entries - 1)];
+        if (cqe.user_data == POLL_REMOVE_USER_DATA) {
+            continue;
+        }
+
+        const uint32_t index = cqe.user_data & 0xffffffff;
+        Op &op = _ops[index];
+        Completion completion{op.user_data, cqe.res, {}};
+        switch (op.kind) {
+            case OpKind::Read:
+                op.fd->register_read();
+                if (cqe.res == 0) {
+                    op.fd->_internal_fd->_eof = true;
+                }
+                if (cqe.res > 0) {
+                    completion.data = {_buffers + op.buffer * _buffer_size, size_t(cqe.res)};
+                    _held_buffers.push_back(op.buffer);
+                } else {
+                    _free_buffers.push_back(op.buffer);
+                }
+                _completions.push_back(completion);
+                break;
+            case OpKind::Write:
+                op.fd->register_write();
+                _free_buffers.push_back(op.buffer);
+                _completions.push_back(completion);
+                break;
+            case OpKind::Poll:
+                _completions.push_back(completion);
+                break;
+            case OpKind::CanceledPoll:
+                break;
+        }
+
+        op.fd.reset();
+        op.generation++;
+        _free_ops.push_back(index);
+        _in_flight--;
+    }
+    __atomic_store_n(_cq_head, head, __ATOMIC_RELEASE);
+}
+
+//! \param[in] wait_for is the number of operations to wait for
+//! \param[in] timeout_ms is the longest to wait, or negative to wait for as long as it takes
+//! \returns the results of the operations that finished, in the order they finished
+//! \note Fewer than `wait_for` results may come back before the timeout, when there are canceled polls in flight.
+const vector<IoUring::Completion> &IoUring::submit(const unsigned wait_for, const int timeout_ms) {
+    _free_buffers.insert(_free_buffers.end(), _held_buffers.begin(), _held_buffers.end());
+    _held_buffers.clear();
+    _completions.clear();
+
+    // (with a timeout, this waits for it even when there's nothing in flight, which makes a sleep)
+    _enter(timeout_ms < 0 ? min<size_t>(wait_for, _in_flight) : wait_for, timeout_ms);
+    _collect();
+
+    // with no timeout, the results of canceled polls don't count
+    while (timeout_ms < 0 and _completions.size() < wait_for and _in_flight > 0) {
+        _enter(min<size_t>(wait_for - _completions.size(), _in_flight), timeout_ms);
+        _collect();
+    }
+    return _completions;
+}
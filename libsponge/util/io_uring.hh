@@ -0,0 +1,139 @@
+#ifndef SPONGE_LIBSPONGE_IO_URING_HH
+#define SPONGE_LIBSPONGE_IO_URING_HH
+
+#include "buffer.hh"
+#include "file_descriptor.hh"
+
+#include <cstddef>
+#include <cstdint>
+#include <linux/io_uring.h>
+#include <optional>
+#include <string_view>
+#include <vector>
+
+//! \brief An [io_uring(7)](\ref man7::io_uring) instance, which queues reads, writes and polls in memory shared
+//! with the kernel and submits them all (and collects the results of earlier ones) with one system call
+//! \details Reads and writes go through a pool of buffers that is registered with the kernel once, so that the
+//! kernel doesn't have to look up and pin the caller's memory for each operation. If the buffers can't be
+//! registered (e.g. for lack of locked memory), the same buffers are used without registration.
+//!
+//! The constructor throws if the kernel doesn't support io_uring (or the features used here, from Linux 5.11), or
+//! doesn't allow it; available() tells in advance.
+class IoUring {
+  public:
+    //! The result of one operation
+    struct Completion {
+        uint64_t user_data;     //!< The value given when the operation was queued
+        int result;             //!< What the equivalent system call would have returned, or else -errno
+        std::string_view data;  //!< For a read, the bytes read, which stay valid until the next submit()
+    };
+
+  private:
+    //! What an operation in flight is
+    enum class OpKind : uint8_t { Read, Write, Poll, CanceledPoll };
+
+    //! An operation in flight
+    struct Op {
+        OpKind kind{};
+        uint32_t generation{};                //!< Bumped each time the slot is reused, to tell polls apart
+        uint32_t buffer{};                    //!< The buffer of a read or write
+        uint64_t user_data{};                 //!< The caller's value, returned with the Completion
+        std::optional<FileDescriptor> fd{};   //!< The file descriptor of a read or write, kept open until it's done
+    };
+
+    io_uring_params _params{};  //!< Filled in by io_uring_setup
+    FileDescriptor _ring;       //!< The io_uring instance
+
+    //! \name The rings, shared with the kernel
+    //!@{
+    void *_ring_memory{};
+    size_t _ring_memory_size{};
+    io_uring_sqe *_sqes{};
+    unsigned *_sq_tail{};
+    unsigned *_cq_head{};
+    const unsigned *_sq_head{};
+    const unsigned *_cq_tail{};
+    const io_uring_cqe *_cqes{};
+    unsigned _queued{};  //!< Submission queue entries filled in since the last submit
+    //!@}
+
+    //! \name The buffers for reads and writes
+    //!@{
+    char *_buffers{};
+    size_t _buffer_count{};
+    size_t _buffer_size{};
+    bool _registered_buffers{};
+    std::vector<uint32_t> _free_buffers{};
+    std::vector<uint32_t> _held_buffers{};  //!< Buffers of reads whose data the caller has until the next submit
+    //!@}
+
+    std::vector<Op> _ops{};
+    std::vector<uint32_t> _free_ops{};
+    size_t _in_flight{};
+    std::vector<Completion> _completions{};
+
+    //! Fill in the params and call io_uring_setup
+    static int _setup(const unsigned entries, io_uring_params &params);
+
+    //! The next free submission queue entry (submitting the queued ones if there are none)
+    io_uring_sqe &_next_sqe();
+
+    //! A free slot for an operation
+    uint32_t _new_op(const OpKind kind, const uint64_t user_data);
+
+    //! Call io_uring_enter to submit what's queued and wait for `wait_for` completions
+    void _enter(const unsigned wait_for, const int timeout_ms);
+
+    //! Turn the completion queue's entries into Completions
+    void _collect();
+
+  public:
+    //! \brief Set up a ring of `entries` submission queue entries, and `buffers` buffers of `buffer_size` bytes
+    explicit IoUring(const unsigned entries = 256, const size_t buffers = 0, const size_t buffer_size = 65536);
+
+    ~IoUring();
+
+    IoUring(const IoUring &other) = delete;
+    IoUring &operator=(const IoUring &other) = delete;
+
+    //! \brief Whether io_uring can be used here
+    static bool available();
+
+    //! \brief Queue a read of up to buffer_size() bytes from `fd` into one of the buffers
+    //! \details `fd` can be any FileDescriptor: a read of a UDPSocket gets one datagram (but not who sent it), and
+    //! a read of a TunFD gets one packet. The completion's result of 0 means EOF, as with FileDescriptor::read.
+    //! \returns `false` if all the buffers are in use
+    bool read(const FileDescriptor &fd, const uint64_t user_data);
+
+    //! \brief Queue a write of `data` to `fd`, copied into one of the buffers
+    //! \details `data` must fit in one buffer; a write to a UDPSocket (which must be connected) or a TunFD sends it
+    //! as one datagram or packet. As with [write(2)](\ref man2::write), the completion's result may be short.
+    //! \returns `false` if all the buffers are in use
+    bool write(const FileDescriptor &fd, const BufferViewList &data, const uint64_t user_data);
+
+    //! \brief Queue a one-shot poll of file descriptor `fd_num` for `events` (e.g. POLLIN)
+    //! \details The completion's result is the events that happened, as in `pollfd::revents`.
+    //! \returns a handle with which to cancel the poll
+    uint64_t poll(const int fd_num, const uint32_t events, const uint64_t user_data);
+
+    //! \brief Cancel a poll, unless it has already been returned by submit(); its result won't be returned
+    void cancel_poll(const uint64_t handle);
+
+    //! \brief Submit everything that's queued, wait until `wait_for` operations have finished (but no longer than
+    //! `timeout_ms`, if it isn't negative), and collect the results of the ones that have finished
+    //! \details The buffers of the reads returned by the last call go back in the pool first, so a caller that queues
+    //! a read in place of each one that finishes needs twice as many buffers as it has reads in flight.
+    const std::vector<Completion> &submit(const unsigned wait_for = 0, const int timeout_ms = -1);
+
+    //! \brief Number of operations queued or submitted whose results haven't been returned yet
+    size_t in_flight() const { return _in_flight; }
+
+    //! \name Buffers
+    //!@{
+    size_t buffer_size() const { return _buffer_size; }
+    size_t free_buffers() const { return _free_buffers.size(); }
+    bool registered_buffers() const { return _registered_buffers; }
+    //!@}
+};
+
+#endif  // SPONGE_LIBSPONGE_IO_URING_HH
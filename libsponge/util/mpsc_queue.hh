@@ -0,0 +1,59 @@
+#ifndef SPONGE_LIBSPONGE_MPSC_QUEUE_HH
+#define SPONGE_LIBSPONGE_MPSC_QUEUE_HH
+
+#include <atomic>
+#include <optional>
+#include <utility>
+
+//! \brief A lock-free queue that any number of threads can push onto, and one thread pops from
+//! \details A linked list with a dummy node at the consumer's end (D. Vyukov's design): push() is one atomic
+//! exchange and one store, and never waits for other producers or for the consumer. An element whose push()
+//! has begun but not finished isn't visible to pop() yet, and neither are the elements behind it.
+template <typename T>
+class MPSCQueue {
+  private:
+    struct Node {
+        std::atomic<Node *> next{nullptr};
+        std::optional<T> value{};
+    };
+
+    std::atomic<Node *> _head;  //!< The most recently pushed node, where producers link new ones
+    Node *_tail;                //!< The consumer's dummy node; the next node is the oldest element
+
+  public:
+    MPSCQueue() : _head(new Node), _tail(_head.load()) {}
+
+    ~MPSCQueue() {
+        while (_tail) {
+            Node *next = _tail->next.load();
+            delete _tail;
+            _tail = next;
+        }
+    }
+
+    MPSCQueue(const MPSCQueue &other) = delete;
+    MPSCQueue &operator=(const MPSCQueue &other) = delete;
+
+    //! \brief Add an element at the back (from any thread)
+    void push(T value) {
+        Node *node = new Node;
+        node->value.emplace(std::move(value));
+        Node *prev = _head.exchange(node);
+        prev->next.store(node);
+    }
+
+    //! \brief Take the element at the front (from the consumer's thread only), if there is one
+    std::optional<T> pop() {
+        Node *next = _tail->next.load();
+        if (not next) {
+            return {};
+        }
+        std::optional<T> ret{std::move(next->value)};
+        next->value.reset();
+        delete _tail;
+        _tail = next;
+        return ret;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_MPSC_QUEUE_HH
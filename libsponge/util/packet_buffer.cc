@@ -0,0 +1,155 @@
+#include "packet_buffer.hh"
+
+#include <array>
+#include <new>
+#include <stdexcept>
+#include <utility>
+
+using namespace std;
+
+//! Size class of blocks that are not pooled
+static constexpr uint8_t UNPOOLED = 0xff;
+
+//! Whether the calling thread's Pool has been destroyed; blocks released after that are freed directly
+static thread_local bool pool_destroyed = false;
+
+//! \details Each size class holds blocks of twice the capacity of the one before. A class keeps at most
+//! MAX_POOLED_BYTES of free blocks (but at least a few), and frees what doesn't fit.
+class PacketBuffer::Pool {
+  private:
+    static constexpr size_t NUM_CLASSES = 11;  // MIN_POOLED_SIZE << 10 == MAX_POOLED_SIZE
+    static constexpr size_t MAX_POOLED_BYTES = size_t{1} << 20;
+    static constexpr size_t MIN_POOLED_BLOCKS = 8;
+
+    std::array<Block *, NUM_CLASSES> _free{};
+    std::array<size_t, NUM_CLASSES> _n_free{};
+
+  public:
+    static Block *allocate(const size_t capacity, const uint8_t size_class) {
+        void *memory = ::operator new(sizeof(Block) + capacity);
+        return new (memory) Block{{1}, size_class, capacity, nullptr};
+    }
+
+    static void deallocate(Block *block) {
+        block->~Block();
+        ::operator delete(block);
+    }
+
+    Pool() = default;
+
+    ~Pool() {
+        pool_destroyed = true;
+        for (Block *block : _free) {
+            while (block) {
+                Block *next = block->next_free;
+                deallocate(block);
+                block = next;
+            }
+        }
+    }
+
+    Pool(const Pool &other) = delete;
+    Pool &operator=(const Pool &other) = delete;
+
+    Block *take(const size_t size) {
+        if (size > MAX_POOLED_SIZE) {
+            return allocate(size, UNPOOLED);
+        }
+
+        uint8_t size_class = 0;
+        while ((MIN_POOLED_SIZE << size_class) < size) {
+            size_class++;
+        }
+        Block *block = _free[size_class];
+        if (block == nullptr) {
+            return allocate(MIN_POOLED_SIZE << size_class, size_class);
+        }
+        _free[size_class] = block->next_free;
+        _n_free[size_class]--;
+        block->refcount.store(1, memory_order_relaxed);
+        return block;
+    }
+
+    void give_back(Block *block) {
+        const uint8_t size_class = block->size_class;
+        if (size_class == UNPOOLED or
+            (_n_free[size_class] >= MIN_POOLED_BLOCKS and
+             (_n_free[size_class] + 1) * block->capacity > MAX_POOLED_BYTES)) {
+            deallocate(block);
+            return;
+        }
+        block->next_free = _free[size_class];
+        _free[size_class] = block;
+        _n_free[size_class]++;
+    }
+
+    size_t size() const {
+        size_t ret = 0;
+        for (const size_t n : _n_free) {
+            ret += n;
+        }
+        return ret;
+    }
+};
+
+PacketBuffer::Pool &PacketBuffer::_pool() {
+    static thread_local Pool pool;
+    return pool;
+}
+
+PacketBuffer::PacketBuffer(const size_t size) : _block(_pool().take(size)), _size(size) {}
+
+PacketBuffer::PacketBuffer(const string_view data) : PacketBuffer(data.size()) {
+    data.copy(_block->data(), data.size());
+}
+
+PacketBuffer::PacketBuffer(const PacketBuffer &other) noexcept : _block(other._block), _size(other._size) {
+    if (_block) {
+        _block->refcount.fetch_add(1, memory_order_relaxed);
+    }
+}
+
+PacketBuffer::PacketBuffer(PacketBuffer &&other) noexcept
+    : _block(exchange(other._block, nullptr)), _size(exchange(other._size, 0)) {}
+
+PacketBuffer &PacketBuffer::operator=(const PacketBuffer &other) noexcept {
+    PacketBuffer copy{other};
+    return *this = move(copy);
+}
+
+PacketBuffer &PacketBuffer::operator=(PacketBuffer &&other) noexcept {
+    if (this != &other) {
+        _release();
+        _block = exchange(other._block, nullptr);
+        _size = exchange(other._size, 0);
+    }
+    return *this;
+}
+
+void PacketBuffer::_release() {
+    if (_block == nullptr or _block->refcount.fetch_sub(1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    if (pool_destroyed) {
+        Pool::deallocate(_block);
+    } else {
+        _pool().give_back(_block);
+    }
+    _block = nullptr;
+}
+
+void PacketBuffer::resize(const size_t size) {
+    if (size > capacity()) {
+        throw length_error("PacketBuffer::resize: more than the block holds");
+    }
+    _size = size;
+}
+
+void PacketBuffer::shrink_to_fit() {
+    if (_block == nullptr or _size > capacity() / 2 or capacity() <= MIN_POOLED_SIZE) {
+        return;
+    }
+    *this = PacketBuffer{str()};
+}
+
+size_t PacketBuffer::pooled_blocks() { return _pool().size(); }
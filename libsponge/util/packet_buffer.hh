@@ -0,0 +1,85 @@
+#ifndef SPONGE_LIBSPONGE_PACKET_BUFFER_HH
+#define SPONGE_LIBSPONGE_PACKET_BUFFER_HH
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+//! \brief A reference-counted block of packet data from a per-thread pool
+//! \details The reference count is kept in the block, in front of the data, so a packet costs one allocation
+//! at most. When the last reference goes away, the block goes on a free list of the thread that let go of it,
+//! and the next packet of the same size class on that thread reuses it without allocating.
+class PacketBuffer {
+  private:
+    //! The header in front of the data of each block
+    struct Block {
+        std::atomic<uint32_t> refcount;  //!< Number of PacketBuffers that refer to the block
+        uint8_t size_class;              //!< Which free list the block goes back to
+        size_t capacity;                 //!< Bytes of data that fit in the block
+        Block *next_free;                //!< Next block on the free list, while the block is free
+
+        char *data() { return reinterpret_cast<char *>(this + 1); }
+    };
+
+    //! The free lists of one thread
+    class Pool;
+
+    //! \returns the calling thread's Pool
+    static Pool &_pool();
+
+    Block *_block{nullptr};
+    size_t _size{};
+
+    //! Drop this reference to the block, recycling it if it was the last one
+    void _release();
+
+  public:
+    //! \name Size classes of pooled blocks; bigger packets are allocated and freed without pooling
+    //!@{
+    static constexpr size_t MIN_POOLED_SIZE = 64;
+    static constexpr size_t MAX_POOLED_SIZE = 65536;
+    //!@}
+
+    PacketBuffer() = default;
+
+    //! \brief Take a block with room for `size` bytes (uninitialized)
+    explicit PacketBuffer(const size_t size);
+
+    //! \brief Take a block and copy `data` into it
+    explicit PacketBuffer(const std::string_view data);
+
+    PacketBuffer(const PacketBuffer &other) noexcept;
+    PacketBuffer(PacketBuffer &&other) noexcept;
+    PacketBuffer &operator=(const PacketBuffer &other) noexcept;
+    PacketBuffer &operator=(PacketBuffer &&other) noexcept;
+    ~PacketBuffer() { _release(); }
+
+    //! \name Contents
+    //! \note Write through data() only before the block is shared, e.g. while filling in a new packet
+    //!@{
+    char *data() { return _block ? _block->data() : nullptr; }
+    const char *data() const { return _block ? _block->data() : nullptr; }
+    size_t size() const { return _size; }
+    std::string_view str() const { return {data(), _size}; }
+    //!@}
+
+    //! \brief Bytes that fit in the block
+    size_t capacity() const { return _block ? _block->capacity : 0; }
+
+    //! \brief Change the size, e.g. to the number of bytes that a read actually returned
+    //! \note Throws std::length_error if `size` exceeds capacity()
+    void resize(const size_t size);
+
+    //! \brief Move the data to a smaller block, if it fits in one half the size or less
+    //! \details E.g. after reading a short packet into a block big enough for any packet, so that the big block
+    //! goes back to the pool for the next read, rather than being held for as long as the packet is.
+    void shrink_to_fit();
+
+    explicit operator bool() const { return _block != nullptr; }
+
+    //! \brief Number of blocks on the calling thread's free lists
+    static size_t pooled_blocks();
+};
+
+#endif  // SPONGE_LIBSPONGE_PACKET_BUFFER_HH
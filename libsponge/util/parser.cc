@@ -1,5 +1,7 @@
 #include "parser.hh"
 
+#include <array>
+
 using namespace std;
 
 //! \param[in] r is the ParseResult to show
@@ -25,23 +27,33 @@ void NetParser::_check_size(const size_t size) {
 
 template <typename T>
 T NetParser::_parse_int() {
-    constexpr size_t len = sizeof(T);
-    _check_size(len);
-    if (error()) {
+    const uint8_t *bytes = peek(sizeof(T));
+    if (bytes == nullptr) {
         return 0;
     }
 
-    T ret = 0;
-    for (size_t i = 0; i < len; i++) {
-        ret <<= 8;
-        ret += uint8_t(_buffer.at(i));
+    T ret;
+    if constexpr (sizeof(T) == sizeof(uint32_t)) {
+        ret = load_u32(bytes);
+    } else if constexpr (sizeof(T) == sizeof(uint16_t)) {
+        ret = load_u16(bytes);
+    } else {
+        ret = bytes[0];
     }
 
-    _buffer.remove_prefix(len);
+    _buffer.remove_prefix(sizeof(T));
 
     return ret;
 }
 
+const uint8_t *NetParser::peek(const size_t n) {
+    _check_size(n);
+    if (error()) {
+        return nullptr;
+    }
+    return reinterpret_cast<const uint8_t *>(_buffer.str().data());
+}
+
 void NetParser::remove_prefix(const size_t n) {
     _check_size(n);
     if (error()) {
@@ -52,11 +64,9 @@ void NetParser::remove_prefix(const size_t n) {
 
 template <typename T>
 void NetUnparser::_unparse_int(string &s, T val) {
-    constexpr size_t len = sizeof(T);
-    for (size_t i = 0; i < len; ++i) {
-        const uint8_t the_byte = (val >> ((len - i - 1) * 8)) & 0xff;
-        s.push_back(the_byte);
-    }
+    array<uint8_t, sizeof(T)> bytes{};
+    _store_int<T>(bytes.data(), val);
+    s.append(bytes.begin(), bytes.end());
 }
 
 uint32_t NetParser::u32() { return _parse_int<uint32_t>(); }
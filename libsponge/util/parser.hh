@@ -5,6 +5,8 @@
 
 #include <cstdint>
 #include <cstdlib>
+#include <cstring>
+#include <endian.h>
 #include <string>
 #include <utility>
 
@@ -60,12 +62,46 @@ class NetParser {
 
     //! Remove n bytes from the buffer
     void remove_prefix(const size_t n);
+
+    //! \brief Check once that `n` more bytes are there, to decode a fixed-size header with the load functions
+    //! \returns a pointer to the next `n` bytes, valid until they are removed, or `nullptr` (setting the error)
+    const uint8_t *peek(const size_t n);
+
+    //! \name Decode integers in network byte order from bytes that peek() returned
+    //!@{
+    static uint32_t load_u32(const uint8_t *bytes) {
+        uint32_t val;
+        memcpy(&val, bytes, sizeof(val));
+        return be32toh(val);
+    }
+
+    static uint16_t load_u16(const uint8_t *bytes) {
+        uint16_t val;
+        memcpy(&val, bytes, sizeof(val));
+        return be16toh(val);
+    }
+    //!@}
 };
 
 struct NetUnparser {
     template <typename T>
     static void _unparse_int(std::string &s, T val);
 
+    //! Generic integer storing method (used by the u32, u16 and u8 that write to caller-provided storage)
+    template <typename T>
+    static uint8_t *_store_int(uint8_t *out, const T val) {
+        T network_order = val;
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+        if constexpr (sizeof(T) == sizeof(uint32_t)) {
+            network_order = __builtin_bswap32(val);
+        } else if constexpr (sizeof(T) == sizeof(uint16_t)) {
+            network_order = __builtin_bswap16(val);
+        }
+#endif
+        memcpy(out, &network_order, sizeof(T));
+        return out + sizeof(T);
+    }
+
     //! Write a 32-bit integer into the data stream in network byte order
     static void u32(std::string &s, const uint32_t val);
 
@@ -74,6 +110,14 @@ struct NetUnparser {
 
     //! Write an 8-bit integer into the data stream in network byte order
     static void u8(std::string &s, const uint8_t val);
+
+    //! \name Write integers in network byte order to caller-provided storage, without allocating
+    //! \returns the position just past the integer
+    //!@{
+    static uint8_t *u32(uint8_t *out, const uint32_t val) { return _store_int<uint32_t>(out, val); }
+    static uint8_t *u16(uint8_t *out, const uint16_t val) { return _store_int<uint16_t>(out, val); }
+    static uint8_t *u8(uint8_t *out, const uint8_t val) { return _store_int<uint8_t>(out, val); }
+    //!@}
 };
 
 #endif  // SPONGE_LIBSPONGE_PARSER_HH
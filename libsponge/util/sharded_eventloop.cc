@@ -0,0 +1,107 @@
+#include "sharded_eventloop.hh"
+
+#include "util.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string_view>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+using namespace std;
+
+ShardedEventLoop::Shard::Shard() : wakeup(SystemCall("eventfd", eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC))) {}
+
+void ShardedEventLoop::_run(Shard &shard) {
+    // when woken, run whatever tasks have been posted
+    shard.loop.add_rule(shard.wakeup, Direction::In, [&shard] {
+        shard.wakeup.read(sizeof(uint64_t));
+        shard.wakeup_pending = false;
+        while (auto task = shard.tasks.pop()) {
+            (*task)(shard.loop);
+        }
+    });
+
+    while (not shard.stopping) {
+        shard.loop.wait_next_event(-1);
+    }
+}
+
+//! \param[in] shards is the number of shards (and threads) to run
+//! \param[in] pin is whether to pin shard `i`'s thread to core `i` (modulo the number of cores), so that each
+//!                connection's state stays in one core's caches; pinning is best-effort, e.g. in a container
+//!                that restricts which cores may be used
+ShardedEventLoop::ShardedEventLoop(const size_t shards, const bool pin) {
+    const size_t cores = max(1u, thread::hardware_concurrency());
+    try {
+        for (size_t i = 0; i < max(shards, size_t{1}); i++) {
+            _shards.push_back(make_unique<Shard>());
+            Shard &shard = *_shards.back();
+            shard.thread = thread([&shard] { _run(shard); });
+
+            if (pin) {
+                cpu_set_t cpus;
+                CPU_ZERO(&cpus);
+                CPU_SET(i % cores, &cpus);
+                pthread_setaffinity_np(shard.thread.native_handle(), sizeof(cpus), &cpus);
+            }
+        }
+    } catch (...) {
+        // the destructor won't run, so the threads already started have to be stopped here
+        stop();
+        throw;
+    }
+}
+
+//! \param[in] shard is the number of the shard to run `task` on
+//! \param[in] task is run on the shard's thread, after the tasks posted before it
+void ShardedEventLoop::post(const size_t shard, Task task) {
+    Shard &target = *_shards.at(shard);
+    target.tasks.push(move(task));
+
+    // wake the shard, unless a wakeup is already on its way
+    if (not target.wakeup_pending.exchange(true)) {
+        const uint64_t one = 1;
+        SystemCall("write", ::write(target.wakeup.fd_num(), &one, sizeof(one)));
+    }
+}
+
+//! A number for an endpoint: the IPv4 address and port, or a hash of any other kind of address
+static uint64_t endpoint_key(const Address &address) {
+    const sockaddr *raw = address;
+    if (raw->sa_family == AF_INET and address.size() == sizeof(sockaddr_in)) {
+        sockaddr_in ipv4{};
+        memcpy(&ipv4, raw, sizeof(ipv4));
+        return (uint64_t{be32toh(ipv4.sin_addr.s_addr)} << 16) | be16toh(ipv4.sin_port);
+    }
+    return hash<string_view>{}({reinterpret_cast<const char *>(raw), address.size()});
+}
+
+//! \details The endpoints are put in order first, so that both ends of a connection (or a server's accepted
+//! socket and the packets that a client sends it) get the same hash.
+uint64_t ShardedEventLoop::flow_hash(const Address &local, const Address &peer) {
+    const uint64_t a = endpoint_key(local), b = endpoint_key(peer);
+
+    // splitmix64's finalizer, to spread nearby ports over all the shards
+    uint64_t x = min(a, b) * 0x9e3779b97f4a7c15 ^ max(a, b);
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111eb;
+    return x ^ (x >> 31);
+}
+
+void ShardedEventLoop::stop() {
+    for (size_t i = 0; i < _shards.size(); i++) {
+        Shard &shard = *_shards[i];
+        if (shard.thread.joinable()) {
+            post(i, [&shard](EventLoop &) { shard.stopping = true; });
+        }
+    }
+    for (auto &shard : _shards) {
+        if (shard->thread.joinable()) {
+            shard->thread.join();
+        }
+    }
+}
@@ -0,0 +1,82 @@
+#ifndef SPONGE_LIBSPONGE_SHARDED_EVENTLOOP_HH
+#define SPONGE_LIBSPONGE_SHARDED_EVENTLOOP_HH
+
+#include "address.hh"
+#include "eventloop.hh"
+#include "file_descriptor.hh"
+#include "mpsc_queue.hh"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+
+//! \brief Runs N EventLoops ("shards"), each on its own thread, and hands connections to them by flow hash
+//! \details Each shard owns its EventLoop (with Backend::Epoll) and everything registered on it, so rules and
+//! timers on a shard are only ever touched by that shard's thread. Other threads reach a shard by posting a
+//! task to it, which goes on the shard's lock-free queue and wakes the shard with an eventfd.
+class ShardedEventLoop {
+  public:
+    //! Work for a shard, which runs on the shard's thread with the shard's EventLoop
+    using Task = std::function<void(EventLoop &)>;
+
+  private:
+    //! One EventLoop, its thread, and its queue of tasks from other threads
+    struct Shard {
+        EventLoop loop{EventLoop::Backend::Epoll};
+        MPSCQueue<Task> tasks{};
+        FileDescriptor wakeup;                   //!< An eventfd, written to when tasks are waiting
+        std::atomic<bool> wakeup_pending{false};  //!< Whether `wakeup` has been written to since it was read
+        bool stopping{false};                    //!< Set by the task that stop() posts
+        std::thread thread{};
+
+        Shard();
+    };
+
+    std::vector<std::unique_ptr<Shard>> _shards{};
+
+    //! The body of each shard's thread
+    static void _run(Shard &shard);
+
+  public:
+    //! \brief Start `shards` shards, each on a thread pinned to its own core if `pin` is set
+    explicit ShardedEventLoop(const size_t shards = std::thread::hardware_concurrency(), const bool pin = true);
+
+    //! \brief Stop all shards and wait for their threads to finish
+    ~ShardedEventLoop() { stop(); }
+
+    ShardedEventLoop(const ShardedEventLoop &other) = delete;
+    ShardedEventLoop &operator=(const ShardedEventLoop &other) = delete;
+
+    //! \brief Number of shards
+    size_t size() const { return _shards.size(); }
+
+    //! \brief Run `task` on shard number `shard` (from any thread)
+    void post(const size_t shard, Task task);
+
+    //! \brief A hash of a connection's two endpoints, which is the same from either end
+    static uint64_t flow_hash(const Address &local, const Address &peer);
+
+    //! \brief The shard that a connection belongs on
+    size_t shard_for(const Address &local, const Address &peer) const { return flow_hash(local, peer) % size(); }
+
+    //! \brief Hand a connected socket over to the shard that its flow hash picks
+    //! \details `setup` runs on the shard's thread, and typically adds rules whose callbacks keep the socket.
+    //! \returns the shard that the socket went to
+    template <typename SocketT, typename Setup>
+    size_t assign(SocketT &&socket, Setup &&setup) {
+        const size_t shard = shard_for(socket.local_address(), socket.peer_address());
+        auto shared = std::make_shared<std::decay_t<SocketT>>(std::forward<SocketT>(socket));
+        post(shard, [shared, setup = std::forward<Setup>(setup)](EventLoop &loop) { setup(loop, shared); });
+        return shard;
+    }
+
+    //! \brief Stop all shards, after the tasks already posted to them, and wait for their threads to finish
+    void stop();
+};
+
+#endif  // SPONGE_LIBSPONGE_SHARDED_EVENTLOOP_HH
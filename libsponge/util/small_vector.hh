@@ -0,0 +1,96 @@
+#ifndef SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+#define SPONGE_LIBSPONGE_SMALL_VECTOR_HH
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <iterator>
+#include <utility>
+#include <vector>
+
+//! \brief A sequence that keeps its first `N` elements inline, and only allocates when it holds more
+//! \details Meant for short lists of cheap, default-constructible elements, like the pieces of a packet:
+//! unused inline slots hold default-constructed elements. Elements can be removed from the front (which
+//! only advances the start) as well as added at the back. Iterators are pointers, invalidated by push_back().
+template <typename T, size_t N>
+class SmallVector {
+  private:
+    std::array<T, N> _inline{};
+    std::vector<T> _heap{};  //!< Holds the elements instead of `_inline` once they haven't fit
+    bool _spilled{};
+    size_t _begin{};  //!< Index of the first element, after pop_front()
+    size_t _size{};
+
+    T *_storage() { return _spilled ? _heap.data() : _inline.data(); }
+    const T *_storage() const { return _spilled ? _heap.data() : _inline.data(); }
+
+  public:
+    //! \name Element access
+    //!@{
+    T *begin() { return _storage() + _begin; }
+    T *end() { return begin() + _size; }
+    const T *begin() const { return _storage() + _begin; }
+    const T *end() const { return begin() + _size; }
+    T *data() { return begin(); }
+    const T *data() const { return begin(); }
+
+    T &operator[](const size_t i) { return begin()[i]; }
+    const T &operator[](const size_t i) const { return begin()[i]; }
+    T &front() { return *begin(); }
+    const T &front() const { return *begin(); }
+    T &back() { return end()[-1]; }
+    const T &back() const { return end()[-1]; }
+    //!@}
+
+    size_t size() const { return _size; }
+    bool empty() const { return _size == 0; }
+
+    void push_back(T value) {
+        if (not _spilled and _begin + _size == N) {
+            if (_begin == 0) {
+                // out of room: move everything to the heap for good
+                _heap.reserve(2 * N);
+                std::move(_inline.begin(), _inline.end(), std::back_inserter(_heap));
+                std::fill(_inline.begin(), _inline.end(), T{});
+                _spilled = true;
+            } else {
+                // slide the elements back to the start of the inline slots
+                std::move(begin(), end(), _inline.begin());
+                std::fill(_inline.begin() + _size, _inline.end(), T{});
+                _begin = 0;
+            }
+        }
+
+        if (_spilled) {
+            _heap.push_back(std::move(value));
+        } else {
+            _inline[_begin + _size] = std::move(value);
+        }
+        _size++;
+    }
+
+    void pop_front() {
+        front() = T{};
+        _begin++;
+        _size--;
+        if (_size == 0) {
+            clear();
+        } else if (_spilled and _begin >= _size) {
+            _heap.erase(_heap.begin(), _heap.begin() + _begin);
+            _begin = 0;
+        }
+    }
+
+    //! \note Keeps the heap storage, if any, for reuse
+    void clear() {
+        if (_spilled) {
+            _heap.clear();
+        } else {
+            std::fill(_inline.begin() + _begin, _inline.begin() + _begin + _size, T{});
+        }
+        _begin = 0;
+        _size = 0;
+    }
+};
+
+#endif  // SPONGE_LIBSPONGE_SMALL_VECTOR_HH
@@ -2,7 +2,11 @@
 
 #include "util.hh"
 
+#include <algorithm>
+#include <array>
 #include <cstddef>
+#include <cstring>
+#include <netinet/udp.h>
 #include <stdexcept>
 #include <unistd.h>
 
@@ -85,25 +89,28 @@ void Socket::shutdown(const int how) {
 }
 
 //! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
-void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
+size_t UDPSocket::_recv(char *data, const size_t mtu, Address &source_address) {
     // receive source address and payload
     Address::Raw datagram_source_address;
-    datagram.payload.resize(mtu);
-
     socklen_t fromlen = sizeof(datagram_source_address);
 
-    const ssize_t recv_len = SystemCall(
-        "recvfrom",
-        ::recvfrom(
-            fd_num(), datagram.payload.data(), datagram.payload.size(), MSG_TRUNC, datagram_source_address, &fromlen));
+    const ssize_t recv_len =
+        SystemCall("recvfrom", ::recvfrom(fd_num(), data, mtu, MSG_TRUNC, datagram_source_address, &fromlen));
 
     if (recv_len > ssize_t(mtu)) {
         throw runtime_error("recvfrom (oversized datagram)");
     }
 
     register_read();
-    datagram.source_address = {datagram_source_address, fromlen};
-    datagram.payload.resize(recv_len);
+    source_address = {datagram_source_address, fromlen};
+    return recv_len;
+}
+
+//! \details The datagram is received into a pooled PacketBuffer and copied to the payload, rather than the payload
+//! being resized to `mtu` (and zero-filled) for each datagram.
+void UDPSocket::recv(received_datagram &datagram, const size_t mtu) {
+    PacketBuffer buffer{mtu};
+    datagram.payload.assign(buffer.data(), _recv(buffer.data(), mtu, datagram.source_address));
 }
 
 UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
@@ -112,16 +119,26 @@ UDPSocket::received_datagram UDPSocket::recv(const size_t mtu) {
     return ret;
 }
 
+//! \note If `mtu` is too small to hold the received datagram, this method throws a std::runtime_error
+UDPSocket::received_buffer UDPSocket::recv_buffer(const size_t mtu) {
+    received_buffer ret{{nullptr, 0}, {}};
+    PacketBuffer buffer{mtu};
+    buffer.resize(_recv(buffer.data(), mtu, ret.source_address));
+    buffer.shrink_to_fit();
+    ret.payload = move(buffer);
+    return ret;
+}
+
 void sendmsg_helper(const int fd_num,
                     const sockaddr *destination_address,
                     const socklen_t destination_address_len,
                     const BufferViewList &payload) {
-    auto iovecs = payload.as_iovecs();
+    const auto &iovecs = payload.as_iovecs();
 
     msghdr message{};
     message.msg_name = const_cast<sockaddr *>(destination_address);
     message.msg_namelen = destination_address_len;
-    message.msg_iov = iovecs.data();
+    message.msg_iov = const_cast<iovec *>(iovecs.data());
     message.msg_iovlen = iovecs.size();
 
     const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num, &message, 0));
@@ -141,6 +158,265 @@ void UDPSocket::send(const BufferViewList &payload) {
     register_write();
 }
 
+//! \param[in] capacity is the maximum number of messages received by each batch
+//! \param[in] mtu is the size of the largest message that can be received
+UDPSocket::received_batch::received_batch(const size_t capacity, const size_t mtu)
+    : _mtu(mtu)
+    , _payloads(capacity * mtu)
+    , _source_addresses(capacity)
+    , _controls(capacity)
+    , _iovecs(capacity)
+    , _headers(capacity)
+    , _datagrams() {
+    _datagrams.reserve(capacity);
+}
+
+string_view UDPSocket::received_batch::payload(const size_t i) const {
+    const Datagram &datagram = _datagrams.at(i);
+    return {_payloads.data() + datagram.offset, datagram.length};
+}
+
+Address UDPSocket::received_batch::source_address(const size_t i) const {
+    const size_t message = _datagrams.at(i).message;
+    return {_source_addresses[message], _headers[message].msg_hdr.msg_namelen};
+}
+
+//! \returns the number of datagrams received, which are then available from `batch`
+//! \note Blocks only until the first datagram arrives, and then takes whatever else is already waiting.
+//! \note If any message is too big for the batch's `mtu`, this method throws a std::runtime_error
+size_t UDPSocket::recv_batch(received_batch &batch) {
+    for (size_t i = 0; i < batch.capacity(); i++) {
+        batch._iovecs[i] = {batch._payloads.data() + i * batch._mtu, batch._mtu};
+        batch._headers[i] = {};
+        batch._headers[i].msg_hdr.msg_name = batch._source_addresses[i];
+        batch._headers[i].msg_hdr.msg_namelen = sizeof(batch._source_addresses[i]);
+        batch._headers[i].msg_hdr.msg_iov = &batch._iovecs[i];
+        batch._headers[i].msg_hdr.msg_iovlen = 1;
+        batch._headers[i].msg_hdr.msg_control = batch._controls[i].buffer.data();
+        batch._headers[i].msg_hdr.msg_controllen = batch._controls[i].buffer.size();
+    }
+
+    batch._datagrams.clear();
+    const int received = SystemCall(
+        "recvmmsg", ::recvmmsg(fd_num(), batch._headers.data(), batch.capacity(), MSG_WAITFORONE, nullptr));
+    register_read();
+
+    for (int i = 0; i < received; i++) {
+        msghdr &message = batch._headers[i].msg_hdr;
+        if (message.msg_flags & MSG_TRUNC) {
+            throw runtime_error("recvmmsg (oversized datagram)");
+        }
+
+        // a train comes with the size of the datagrams that it was made of
+        const size_t length = batch._headers[i].msg_len;
+        size_t datagram_size = length;
+        for (cmsghdr *control = CMSG_FIRSTHDR(&message); control; control = CMSG_NXTHDR(&message, control)) {
+            if (control->cmsg_level == SOL_UDP and control->cmsg_type == UDP_GRO) {
+                int gso_size;
+                memcpy(&gso_size, CMSG_DATA(control), sizeof(gso_size));
+                if (gso_size > 0) {
+                    datagram_size = gso_size;
+                }
+            }
+        }
+
+        size_t offset = 0;
+        do {
+            const size_t datagram_length = min(datagram_size, length - offset);
+            batch._datagrams.push_back({i * batch._mtu + offset, datagram_length, size_t(i)});
+            offset += datagram_length;
+        } while (offset < length);
+    }
+
+    return batch.size();
+}
+
+// send datagrams with as few calls to sendmmsg() as possible
+//! \param[in] count is the number of datagrams to send
+//! \param[in] destination gives the address for the `i`th datagram, or `nullptr` on a connected socket
+//! \param[in] payload gives the `i`th datagram's payload
+//! \returns the number of datagrams sent; fewer than `count` only if the socket is non-blocking and full
+template <typename Destination, typename Payload>
+static size_t sendmmsg_helper(const int fd_num,
+                              const size_t count,
+                              const Destination &destination,
+                              const Payload &payload) {
+    // headers for one call to sendmmsg(); the iovecs are the ones the payloads already hold
+    constexpr size_t MAX_BATCH = 64;
+    array<mmsghdr, MAX_BATCH> headers;
+
+    size_t sent = 0;
+    while (sent < count) {
+        const size_t batch = min(count - sent, MAX_BATCH);
+        for (size_t i = 0; i < batch; i++) {
+            const Address *address = destination(sent + i);
+            const auto &iovecs = payload(sent + i).as_iovecs();
+            headers[i] = {};
+            if (address) {
+                headers[i].msg_hdr.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(*address));
+                headers[i].msg_hdr.msg_namelen = address->size();
+            }
+            headers[i].msg_hdr.msg_iov = const_cast<iovec *>(iovecs.data());
+            headers[i].msg_hdr.msg_iovlen = iovecs.size();
+        }
+
+        const int batch_sent = SystemCall("sendmmsg", ::sendmmsg(fd_num, headers.data(), batch, 0), EAGAIN);
+        for (int i = 0; i < batch_sent; i++) {
+            if (headers[i].msg_len != payload(sent + i).size()) {
+                throw runtime_error("datagram payload too big for sendmmsg()");
+            }
+        }
+
+        if (batch_sent <= 0) {
+            break;
+        }
+        sent += batch_sent;
+        if (size_t(batch_sent) < batch) {
+            break;
+        }
+    }
+
+    return sent;
+}
+
+// send datagrams as trains of equal-sized datagrams, one call to sendmsg() per train
+//! \param[in] count is the number of datagrams to send
+//! \param[in] destination gives the address for the `i`th datagram, or `nullptr` on a connected socket
+//! \param[in] payload gives the `i`th datagram's payload
+//! \returns the number of datagrams sent; fewer than `count` only if the socket is non-blocking and full
+//! \details A train is a run of datagrams to the same destination that are all the same size, except that the
+//! last one can be shorter. The kernel splits it at that size ([UDP_SEGMENT](\ref man7::udp)).
+template <typename Destination, typename Payload>
+static size_t send_trains_helper(const int fd_num,
+                                 const size_t count,
+                                 const Destination &destination,
+                                 const Payload &payload) {
+    // the biggest train the kernel takes: 64 datagrams, which have to fit in one IPv4 datagram together
+    constexpr size_t MAX_TRAIN_DATAGRAMS = 64, MAX_TRAIN_BYTES = 65507, MAX_TRAIN_IOVECS = 256;
+    array<iovec, MAX_TRAIN_IOVECS> iovecs;
+    union {
+        cmsghdr header;
+        array<char, CMSG_SPACE(sizeof(uint16_t))> buffer;
+    } control;
+
+    size_t sent = 0;
+    while (sent < count) {
+        const Address *address = destination(sent);
+        const size_t datagram_size = payload(sent).size();
+
+        // make the train as long as it can be
+        size_t train = 0, train_bytes = 0, train_iovecs = 0;
+        while (sent + train < count and train < MAX_TRAIN_DATAGRAMS) {
+            const BufferViewList &next = payload(sent + train);
+            const auto &next_iovecs = next.as_iovecs();
+            const Address *next_address = destination(sent + train);
+            // (an empty datagram goes by itself: the kernel can't fit one in a train, and takes a segment size of 0
+            // to mean a single datagram)
+            if ((train > 0 and (next.size() > datagram_size or next.size() == 0)) or
+                train_bytes + next.size() > MAX_TRAIN_BYTES or
+                train_iovecs + next_iovecs.size() > MAX_TRAIN_IOVECS or
+                (address ? not next_address or *next_address != *address : next_address != nullptr)) {
+                break;
+            }
+            copy(next_iovecs.begin(), next_iovecs.end(), iovecs.begin() + train_iovecs);
+            train_iovecs += next_iovecs.size();
+            train_bytes += next.size();
+            train++;
+            if (next.size() < datagram_size or datagram_size == 0) {
+                break;
+            }
+        }
+
+        // a datagram that doesn't fit in a train on its own goes by itself
+        if (train == 0) {
+            if (address) {
+                sendmsg_helper(fd_num, *address, address->size(), payload(sent));
+            } else {
+                sendmsg_helper(fd_num, nullptr, 0, payload(sent));
+            }
+            sent++;
+            continue;
+        }
+
+        msghdr message{};
+        if (address) {
+            message.msg_name = const_cast<sockaddr *>(static_cast<const sockaddr *>(*address));
+            message.msg_namelen = address->size();
+        }
+        message.msg_iov = iovecs.data();
+        message.msg_iovlen = train_iovecs;
+        if (train > 1) {
+            message.msg_control = control.buffer.data();
+            message.msg_controllen = control.buffer.size();
+            cmsghdr *const segment_size = CMSG_FIRSTHDR(&message);
+            segment_size->cmsg_level = SOL_UDP;
+            segment_size->cmsg_type = UDP_SEGMENT;
+            segment_size->cmsg_len = CMSG_LEN(sizeof(uint16_t));
+            const uint16_t size = datagram_size;
+            memcpy(CMSG_DATA(segment_size), &size, sizeof(size));
+        }
+
+        const ssize_t bytes_sent = SystemCall("sendmsg", ::sendmsg(fd_num, &message, 0), EAGAIN);
+        if (bytes_sent < 0) {
+            break;
+        }
+        if (size_t(bytes_sent) != train_bytes) {
+            throw runtime_error("datagram train too big for sendmsg()");
+        }
+        sent += train;
+    }
+
+    return sent;
+}
+
+//! \returns the number of datagrams sent, from the front of `datagrams`
+//! \note On a non-blocking socket, this can be fewer than all of them; the rest are for the caller to retry.
+size_t UDPSocket::sendto_batch(const vector<outgoing_datagram> &datagrams) {
+    const size_t sent = sendmmsg_helper(
+        fd_num(),
+        datagrams.size(),
+        [&](const size_t i) { return &datagrams[i].destination; },
+        [&](const size_t i) -> const BufferViewList & { return datagrams[i].payload; });
+    register_write();
+    return sent;
+}
+
+//! \returns the number of datagrams sent, from the front of `payloads`
+//! \note On a non-blocking socket, this can be fewer than all of them; the rest are for the caller to retry.
+size_t UDPSocket::send_batch(const vector<BufferViewList> &payloads) {
+    const size_t sent = sendmmsg_helper(
+        fd_num(),
+        payloads.size(),
+        [](const size_t) -> const Address * { return nullptr; },
+        [&](const size_t i) -> const BufferViewList & { return payloads[i]; });
+    register_write();
+    return sent;
+}
+
+//! \returns the number of datagrams sent, from the front of `datagrams`
+//! \note On a non-blocking socket, this can be fewer than all of them; the rest are for the caller to retry.
+size_t UDPSocket::sendto_trains(const vector<outgoing_datagram> &datagrams) {
+    const size_t sent = send_trains_helper(
+        fd_num(),
+        datagrams.size(),
+        [&](const size_t i) { return &datagrams[i].destination; },
+        [&](const size_t i) -> const BufferViewList & { return datagrams[i].payload; });
+    register_write();
+    return sent;
+}
+
+//! \returns the number of datagrams sent, from the front of `payloads`
+//! \note On a non-blocking socket, this can be fewer than all of them; the rest are for the caller to retry.
+size_t UDPSocket::send_trains(const vector<BufferViewList> &payloads) {
+    const size_t sent = send_trains_helper(
+        fd_num(),
+        payloads.size(),
+        [](const size_t) -> const Address * { return nullptr; },
+        [&](const size_t i) -> const BufferViewList & { return payloads[i]; });
+    register_write();
+    return sent;
+}
+
 // mark the socket as listening for incoming connections
 //! \param[in] backlog is the number of waiting connections to queue (see [listen(2)](\ref man2::listen))
 void TCPSocket::listen(const int backlog) { SystemCall("listen", ::listen(fd_num(), backlog)); }
@@ -166,3 +442,7 @@ void Socket::setsockopt(const int level, const int option, const option_type &op
 // allow local address to be reused sooner, at the cost of some robustness
 //! \note Using `SO_REUSEADDR` may reduce the robustness of your application
 void Socket::set_reuseaddr() { setsockopt(SOL_SOCKET, SO_REUSEADDR, int(true)); }
+
+// have the kernel hand over datagrams that arrive in a row from the same source as one train
+//! \note Requires Linux 5.0 or later; recv_batch() splits the trains back into datagrams
+void UDPSocket::set_gro() { setsockopt(SOL_UDP, UDP_GRO, int(true)); }
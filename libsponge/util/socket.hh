@@ -4,10 +4,13 @@
 #include "address.hh"
 #include "file_descriptor.hh"
 
+#include <array>
 #include <cstdint>
 #include <functional>
 #include <string>
+#include <string_view>
 #include <sys/socket.h>
+#include <vector>
 
 //! \brief Base class for network sockets (TCP, UDP, etc.)
 //! \details Socket is generally used via a subclass. See TCPSocket and UDPSocket for usage examples.
@@ -49,6 +52,10 @@ class Socket : public FileDescriptor {
 
 //! A wrapper around [UDP sockets](\ref man7::udp)
 class UDPSocket : public Socket {
+  private:
+    //! Receive a datagram of up to `mtu` bytes into `data`, and the Address of its sender
+    size_t _recv(char *data, const size_t mtu, Address &source_address);
+
   protected:
     //! \brief Construct from FileDescriptor (used by TCPOverUDPSocketAdapter)
     //! \param[in] fd is the FileDescriptor from which to construct
@@ -70,11 +77,104 @@ class UDPSocket : public Socket {
     //! Receive a datagram and the Address of its sender (caller can allocate storage)
     void recv(received_datagram &datagram, const size_t mtu = 65536);
 
+    //! Returned by UDPSocket::recv_buffer; like received_datagram, but with the payload in a pooled Buffer
+    struct received_buffer {
+        Address source_address;  //!< Address from which this datagram was received
+        Buffer payload;          //!< UDP datagram payload
+    };
+
+    //! Receive a datagram into a pooled buffer (without allocating, once the pool is warm), and the Address of its
+    //! sender
+    received_buffer recv_buffer(const size_t mtu = 65536);
+
     //! Send a datagram to specified Address
     void sendto(const Address &destination, const BufferViewList &payload);
 
     //! Send datagram to the socket's connected address (must call connect() first)
     void send(const BufferViewList &payload);
+
+    //! \name Batched I/O
+    //! Each batch costs one [recvmmsg(2)](\ref man2::recvmmsg) or [sendmmsg(2)](\ref man2::sendmmsg) call,
+    //! rather than one system call per datagram.
+    //!@{
+
+    //! \brief Caller-owned storage for the datagrams received by recv_batch()
+    //! \details Room for every datagram is allocated once, up front, and reused by each batch.
+    //! \details With set_gro(), each of the `capacity` messages can be a train of datagrams, which the batch
+    //! splits back into the datagrams it was made of.
+    class received_batch {
+      private:
+        //! Room for the [UDP_GRO](\ref man7::udp) control message that gives the size of a train's datagrams
+        struct Control {
+            alignas(cmsghdr) std::array<char, CMSG_SPACE(sizeof(int))> buffer;
+        };
+
+        //! Where one datagram of the latest batch is
+        struct Datagram {
+            size_t offset;   //!< Start of the datagram in `_payloads`
+            size_t length;   //!< Length of the datagram
+            size_t message;  //!< Which message (and so which source address) it came in
+        };
+
+        size_t _mtu;
+        std::vector<char> _payloads;                  //!< Room for `mtu` bytes per message
+        std::vector<Address::Raw> _source_addresses;  //!< Filled in by the kernel
+        std::vector<Control> _controls;               //!< Filled in by the kernel
+        std::vector<iovec> _iovecs;                   //!< Points each message at its room in `_payloads`
+        std::vector<mmsghdr> _headers;                //!< The batch, as passed to recvmmsg
+        std::vector<Datagram> _datagrams;             //!< The datagrams received by the latest batch
+
+        friend class UDPSocket;
+
+      public:
+        //! \brief Make room for a batch of up to `capacity` messages of up to `mtu` bytes each
+        //! \note With set_gro(), a message can be as big as 64 KiB, so `mtu` should be the default.
+        explicit received_batch(const size_t capacity, const size_t mtu = 65536);
+
+        //! \brief Maximum number of messages received at once
+        size_t capacity() const { return _headers.size(); }
+
+        //! \brief Number of datagrams received by the latest batch
+        size_t size() const { return _datagrams.size(); }
+
+        //! \brief Payload of the `i`th datagram, valid until the next batch is received
+        std::string_view payload(const size_t i) const;
+
+        //! \brief Address from which the `i`th datagram was received
+        Address source_address(const size_t i) const;
+    };
+
+    //! Passed to UDPSocket::sendto_batch; a datagram and where to send it
+    struct outgoing_datagram {
+        Address destination;     //!< Address to which this datagram is sent
+        BufferViewList payload;  //!< UDP datagram payload
+    };
+
+    //! Receive at least one, and as many as fit in `batch`, of the datagrams waiting on the socket
+    size_t recv_batch(received_batch &batch);
+
+    //! Send a batch of datagrams, each to its own Address
+    size_t sendto_batch(const std::vector<outgoing_datagram> &datagrams);
+
+    //! Send a batch of datagrams to the socket's connected address (must call connect() first)
+    size_t send_batch(const std::vector<BufferViewList> &payloads);
+    //!@}
+
+    //! \name Segmentation offload
+    //! A train of datagrams of the same size, like full-sized TCP segments, goes through the network stack as one
+    //! big datagram, and is split into its pieces as late as possible (by the NIC, if it can). Each train costs
+    //! one pass through the stack instead of one per datagram.
+    //!@{
+
+    //! Send datagrams as trains with [UDP_SEGMENT](\ref man7::udp), each to its own Address
+    size_t sendto_trains(const std::vector<outgoing_datagram> &datagrams);
+
+    //! Send datagrams as trains to the socket's connected address (must call connect() first)
+    size_t send_trains(const std::vector<BufferViewList> &payloads);
+
+    //! Let datagrams arrive as trains, with [UDP_GRO](\ref man7::udp); recv_batch() splits them again
+    void set_gro();
+    //!@}
 };
 
 //! \class UDPSocket
@@ -83,6 +183,14 @@ class UDPSocket : public Socket {
 //! Example:
 //!
 //! \include socket_example_1.cc
+//!
+//! or, receiving and sending many datagrams at a time:
+//!
+//! \include socket_example_4.cc
+//!
+//! or, with segmentation offload:
+//!
+//! \include socket_example_5.cc
 
 //! A wrapper around [TCP sockets](\ref man7::tcp)
 class TCPSocket : public Socket {
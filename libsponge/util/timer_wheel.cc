@@ -0,0 +1,156 @@
+#include "timer_wheel.hh"
+
+#include <algorithm>
+#include <utility>
+
+using namespace std;
+
+TimerWheel::TimerWheel() { _slots.fill(NONE); }
+
+void TimerWheel::_insert(const uint32_t index) {
+    Timer &timer = _timers[index];
+
+    // the finest wheel whose coming turn reaches the expiry
+    size_t level = 0;
+    while (level + 1 < LEVELS and (timer.expiry >> (SLOT_BITS * level)) - (_now >> (SLOT_BITS * level)) >= SLOTS) {
+        level++;
+    }
+
+    // a timer too far off even for the outermost wheel waits in its furthest slot, and is placed again from there
+    const uint64_t position = min(timer.expiry >> (SLOT_BITS * level), (_now >> (SLOT_BITS * level)) + SLOTS - 1);
+
+    timer.slot = level * SLOTS + (position & (SLOTS - 1));
+    timer.prev = NONE;
+    timer.next = _slots[timer.slot];
+    if (timer.next != NONE) {
+        _timers[timer.next].prev = index;
+    }
+    _slots[timer.slot] = index;
+    _armed_per_level[level]++;
+}
+
+void TimerWheel::_unlink(const uint32_t index) {
+    Timer &timer = _timers[index];
+    if (timer.prev != NONE) {
+        _timers[timer.prev].next = timer.next;
+    } else {
+        _slots[timer.slot] = timer.next;
+    }
+    if (timer.next != NONE) {
+        _timers[timer.next].prev = timer.prev;
+    }
+    _armed_per_level[timer.slot / SLOTS]--;
+}
+
+void TimerWheel::_release(const uint32_t index) {
+    _unlink(index);
+    Timer &timer = _timers[index];
+    timer.callback = nullptr;
+    timer.slot = NONE;
+    timer.generation++;
+    timer.next = _free;
+    _free = index;
+    _armed--;
+}
+
+void TimerWheel::_cascade(const size_t level) {
+    const size_t slot = level * SLOTS + ((_now >> (SLOT_BITS * level)) & (SLOTS - 1));
+    uint32_t index = _slots[slot];
+    _slots[slot] = NONE;
+    while (index != NONE) {
+        const uint32_t next = _timers[index].next;
+        _armed_per_level[level]--;
+        _insert(index);
+        index = next;
+    }
+}
+
+//! \param[in] delay_ms is how long from the wheel's now() until the timer fires
+//! \param[in] callback is called when the timer fires, from advance()
+//! \returns an id with which to cancel the timer
+TimerWheel::TimerId TimerWheel::add(const uint64_t delay_ms, const CallbackT &callback) {
+    uint32_t index = _free;
+    if (index != NONE) {
+        _free = _timers[index].next;
+    } else {
+        index = _timers.size();
+        _timers.emplace_back();
+    }
+
+    Timer &timer = _timers[index];
+    timer.expiry = _now + max(delay_ms, uint64_t{1});
+    timer.callback = callback;
+    _insert(index);
+    _armed++;
+
+    return (uint64_t{timer.generation} << 32) | index;
+}
+
+//! \param[in] id is what add() returned for the timer
+bool TimerWheel::cancel(const TimerId id) {
+    const uint32_t index = id & UINT32_MAX;
+    if (index >= _timers.size() or _timers[index].generation != id >> 32 or _timers[index].slot == NONE) {
+        return false;
+    }
+
+    _release(index);
+    return true;
+}
+
+//! \param[in] now_ms is the new time, which should not be less than now()
+//! \details Callbacks may add and cancel timers. A timer that a callback adds fires no sooner than the next
+//! millisecond, even if the wheel is still on its way to `now_ms`.
+size_t TimerWheel::advance(const uint64_t now_ms) {
+    size_t fired = 0;
+    while (_now < now_ms) {
+        // with nothing armed, there is nothing to move or fire on the way
+        if (_armed == 0) {
+            _now = now_ms;
+            break;
+        }
+
+        // with nothing in the first wheel, skip to the end of its turn
+        if (_armed_per_level[0] == 0) {
+            _now = min(now_ms - 1, _now | (SLOTS - 1));
+        }
+
+        _now++;
+
+        // each time a wheel finishes a turn, the next slot of the wheel outside it moves down
+        size_t turns = 0;
+        while (turns + 1 < LEVELS and (_now & ((uint64_t{1} << (SLOT_BITS * (turns + 1))) - 1)) == 0) {
+            turns++;
+        }
+        for (size_t level = turns; level > 0; level--) {
+            _cascade(level);
+        }
+
+        // fire the timers in the first wheel's slot for now (the callbacks can change the wheel, so each timer
+        // is freed before its callback is called, and the slot is looked at afresh each time)
+        const uint32_t slot = _now & (SLOTS - 1);
+        while (_slots[slot] != NONE) {
+            const uint32_t index = _slots[slot];
+            const CallbackT callback = move(_timers[index].callback);
+            _release(index);
+
+            callback();
+            fired++;
+        }
+    }
+
+    return fired;
+}
+
+optional<uint64_t> TimerWheel::next_expiry() const {
+    if (_armed == 0) {
+        return {};
+    }
+
+    // look through the first wheel up to the end of its turn, when timers may move down into it
+    for (uint64_t delay = 1;; delay++) {
+        const uint64_t time = _now + delay;
+        if (_slots[time & (SLOTS - 1)] != NONE or (time & (SLOTS - 1)) == 0) {
+            return delay;
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+#define SPONGE_LIBSPONGE_TIMER_WHEEL_HH
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <vector>
+
+//! \brief A hierarchical timing wheel: many one-shot timers, at millisecond granularity
+//! \details Timers live in the slots of four wheels of 256 slots each. The first wheel has one slot per
+//! millisecond; each of the others has one slot per turn of the wheel below it. A timer goes in the finest
+//! wheel that reaches its expiry, and moves down a wheel each time its slot comes around, so adding,
+//! canceling and firing a timer each take constant time.
+class TimerWheel {
+  public:
+    using CallbackT = std::function<void(void)>;  //!< Called when a timer expires
+
+    //! Identifies a timer for cancel(); never reused, so canceling a timer that already fired is harmless
+    using TimerId = uint64_t;
+
+  private:
+    static constexpr size_t LEVELS = 4;
+    static constexpr size_t SLOT_BITS = 8;
+    static constexpr size_t SLOTS = size_t{1} << SLOT_BITS;
+    static constexpr uint32_t NONE = UINT32_MAX;  //!< The end of a list of timers
+
+    //! A timer, or (while it's not armed) an entry on the free list
+    struct Timer {
+        uint64_t expiry{};      //!< When the timer fires, in the wheel's milliseconds
+        uint32_t generation{};  //!< Incremented each time the entry is freed, so that old TimerIds go stale
+        uint32_t slot{NONE};    //!< The slot the timer is in, as level * SLOTS + index, or NONE if it's free
+        uint32_t prev{NONE};    //!< Previous timer in the same slot
+        uint32_t next{NONE};    //!< Next timer in the same slot, or on the free list
+        CallbackT callback{};
+    };
+
+    std::vector<Timer> _timers{};  //!< Every timer there has been room for, armed or free
+    uint32_t _free{NONE};          //!< First entry on the free list
+    std::array<uint32_t, LEVELS * SLOTS> _slots{};  //!< First timer in each slot
+    uint64_t _now{};               //!< The wheel's time; every timer that expires by then has fired
+    size_t _armed{};               //!< Number of timers that have not fired or been canceled
+    std::array<size_t, LEVELS> _armed_per_level{};  //!< Number of timers in each wheel
+
+    //! Put a timer in the slot that its expiry calls for
+    void _insert(const uint32_t index);
+
+    //! Take a timer out of its slot
+    void _unlink(const uint32_t index);
+
+    //! Take a timer out of its slot and put its entry on the free list
+    void _release(const uint32_t index);
+
+    //! Move the timers in one slot of an outer wheel down to where they belong now
+    void _cascade(const size_t level);
+
+  public:
+    TimerWheel();
+
+    //! \brief Arm a timer that calls `callback` once `delay_ms` milliseconds from now have passed
+    //! \note A delay of zero is rounded up to 1 ms, so that the timer fires on the next advance()
+    TimerId add(const uint64_t delay_ms, const CallbackT &callback);
+
+    //! \brief Disarm a timer
+    //! \returns `true` if the timer was armed, or `false` if it had fired or been canceled already
+    bool cancel(const TimerId id);
+
+    //! \brief Move the wheel's time forward to `now_ms`, and call the callbacks of the timers that expire by then
+    //! \returns the number of timers that fired
+    size_t advance(const uint64_t now_ms);
+
+    //! \brief The wheel's time, in milliseconds
+    uint64_t now() const { return _now; }
+
+    //! \brief Milliseconds until the next advance() that might fire a timer, or nothing if none is armed
+    //! \details Exact when a timer is due within the next turn of the first wheel; otherwise, the time until
+    //! that wheel's turn is up, which is when timers move down from the outer wheels.
+    std::optional<uint64_t> next_expiry() const;
+
+    //! \brief Number of timers armed
+    size_t size() const { return _armed; }
+
+    bool empty() const { return _armed == 0; }
+};
+
+#endif  // SPONGE_LIBSPONGE_TIMER_WHEEL_HH
@@ -2,6 +2,7 @@
 
 #include "util.hh"
 
+#include <cerrno>
 #include <cstring>
 #include <fcntl.h>
 #include <linux/if.h>
@@ -14,18 +15,24 @@ using namespace std;
 
 //! \param[in] devname is the name of the TUN or TAP device, specified at its creation.
 //! \param[in] is_tun is `true` for a TUN device (expects IP datagrams), or `false` for a TAP device (expects Ethernet frames)
+//! \param[in] multi_queue is `true` to open one queue of a multi-queue device (which must have been created with
+//! `multi_queue`); each TunTapFD opened this way is another queue
 //!
 //! To create a TUN device, you should already have run
 //!
 //!     ip tuntap add mode tun user `username` name `devname`
 //!
+//! (adding `multi_queue` for a multi-queue device)
 //! as root before calling this function.
 
-TunTapFD::TunTapFD(const string &devname, const bool is_tun)
+TunTapFD::TunTapFD(const string &devname, const bool is_tun, const bool multi_queue)
     : FileDescriptor(SystemCall("open", open(CLONEDEV, O_RDWR))) {
     struct ifreq tun_req {};
 
     tun_req.ifr_flags = (is_tun ? IFF_TUN : IFF_TAP) | IFF_NO_PI;  // tun device with no packetinfo
+    if (multi_queue) {
+        tun_req.ifr_flags |= IFF_MULTI_QUEUE;
+    }
 
     // copy devname to ifr_name, making sure to null terminate
 
@@ -34,3 +41,32 @@ TunTapFD::TunTapFD(const string &devname, const bool is_tun)
 
     SystemCall("ioctl", ioctl(fd_num(), TUNSETIFF, static_cast<void *>(&tun_req)));
 }
+
+size_t TunTapFD::read_packets(vector<Buffer> &packets, const size_t max_packets) {
+    size_t count = 0;
+    while (count < max_packets) {
+        PacketBuffer buffer{MAX_PACKET_SIZE};
+        const auto bytes_read = _try_read(buffer.data(), buffer.size(), EAGAIN);
+        if (not bytes_read.has_value() or *bytes_read == 0) {
+            break;  // the queue is empty, or (with eof() now set) the device is gone
+        }
+        buffer.resize(*bytes_read);
+        buffer.shrink_to_fit();
+        packets.emplace_back(move(buffer));
+        count++;
+    }
+    return count;
+}
+
+//! \param[in] devname is the name of the TUN device, which must have been created with `multi_queue`
+//! \param[in] queues is the number of queues to open (at most 256)
+//!
+//! (With CAP_NET_ADMIN, a device that doesn't exist yet is created by the first queue, and goes away with the last.)
+vector<TunFD> TunFD::open_queues(const string &devname, const size_t queues) {
+    vector<TunFD> ret;
+    ret.reserve(queues);
+    for (size_t i = 0; i < queues; i++) {
+        ret.emplace_back(devname, true);
+    }
+    return ret;
+}
@@ -3,20 +3,44 @@
 
 #include "file_descriptor.hh"
 
+#include <cstddef>
 #include <string>
+#include <vector>
 
 //! A FileDescriptor to a [Linux TUN/TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunTapFD : public FileDescriptor {
   public:
+    //! Largest packet (or frame) that read_packet() returns
+    static constexpr size_t MAX_PACKET_SIZE = 65536;
+
     //! Open an existing persistent [TUN or TAP device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunTapFD(const std::string &devname, const bool is_tun);
+    explicit TunTapFD(const std::string &devname, const bool is_tun, const bool multi_queue = false);
+
+    //! \brief Read one packet (or frame) into a pooled buffer
+    //! \details Unlike read(), this doesn't allocate once the pool is warm, and a packet of 1500 bytes is kept in
+    //! a block of 2 KiB.
+    Buffer read_packet() { return read_buffer(MAX_PACKET_SIZE); }
+
+    //! \brief Read the packets (or frames) that are waiting, up to `max_packets`, each into a pooled buffer
+    //! \details Meant for a non-blocking fd (see set_blocking), where it stops once the queue is empty (or at
+    //! EOF) instead of waiting, so that one wakeup of an EventLoop takes the whole batch. (A TUN device has no
+    //! recvmmsg, so each packet is still one read(2).)
+    //! \returns the number of packets appended to `packets`
+    size_t read_packets(std::vector<Buffer> &packets, const size_t max_packets = 64);
 };
 
 //! A FileDescriptor to a [Linux TUN](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
 class TunFD : public TunTapFD {
   public:
     //! Open an existing persistent [TUN device](https://www.kernel.org/doc/Documentation/networking/tuntap.txt).
-    explicit TunFD(const std::string &devname) : TunTapFD(devname, true) {}
+    explicit TunFD(const std::string &devname, const bool multi_queue = false)
+        : TunTapFD(devname, true, multi_queue) {}
+
+    //! \brief Open `queues` queues of a multi-queue TUN device
+    //! \details The kernel hands each outgoing packet to one queue, picked by a hash of its flow, so the packets of
+    //! one connection stay in order on one queue. Giving each queue its own EventLoop (e.g. one shard of a
+    //! ShardedEventLoop each) spreads the packet processing across cores.
+    static std::vector<TunFD> open_queues(const std::string &devname, const size_t queues);
 };
 
 //! A FileDescriptor to a [Linux TAP](https://www.kernel.org/doc/Documentation/networking/tuntap.txt) device
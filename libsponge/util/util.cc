@@ -3,11 +3,18 @@
 #include <array>
 #include <cctype>
 #include <chrono>
+#include <cstring>
 #include <iomanip>
 #include <iostream>
 #include <sstream>
+#include <stdexcept>
 #include <sys/socket.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SPONGE_X86_CHECKSUM_KERNELS
+#endif
+
 using namespace std;
 
 //! \returns the number of milliseconds since the program started
@@ -69,6 +76,113 @@ mt19937 get_random_generator() {
     return mt19937(seed);
 }
 
+//! \returns `sum` folded into 16 bits with end-around carries; zero only if `sum` is zero
+static uint16_t fold(uint64_t sum) {
+    while (sum > 0xffff) {
+        sum = (sum >> 16) + (sum & 0xffff);
+    }
+    return sum;
+}
+
+//! \details Adds the bytes eight at a time, as two 32-bit halves, so the 64-bit sum can't overflow.
+//! The `copy` versions of the kernels also copy the data to `dest` as they go.
+template <bool copy>
+static uint64_t sum_words_scalar(const char *data, [[maybe_unused]] char *dest, const size_t len) {
+    uint64_t sum = 0;
+    size_t i = 0;
+    for (; i + sizeof(uint64_t) <= len; i += sizeof(uint64_t)) {
+        uint64_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if constexpr (copy) {
+            memcpy(dest + i, &word, sizeof(word));
+        }
+        sum += (word & 0xffff'ffff) + (word >> 32);
+    }
+    for (; i < len; i += sizeof(uint16_t)) {
+        uint16_t word;
+        memcpy(&word, data + i, sizeof(word));
+        if constexpr (copy) {
+            memcpy(dest + i, &word, sizeof(word));
+        }
+        sum += word;
+    }
+    return sum;
+}
+
+#ifdef SPONGE_X86_CHECKSUM_KERNELS
+//! Bytes after which the 32-bit lanes of the vector kernels are added into the 64-bit sum: each lane
+//! takes at most 2^16 words in between, so it can't overflow
+static constexpr size_t VECTOR_CHUNK = size_t{1} << 18;
+
+//! \details Each 16-byte block is widened to two vectors of 32-bit lanes, one per half, and added up.
+template <bool copy>
+__attribute__((target("sse2"))) static uint64_t sum_words_sse2(const char *data, char *dest, const size_t len) {
+    const __m128i zero = _mm_setzero_si128();
+    const size_t vector_len = len - len % sizeof(__m128i);
+    uint64_t sum = 0;
+    for (size_t chunk = 0; chunk < vector_len; chunk += VECTOR_CHUNK) {
+        const size_t chunk_end = min(vector_len, chunk + VECTOR_CHUNK);
+        __m128i lanes = zero;
+        for (size_t i = chunk; i < chunk_end; i += sizeof(__m128i)) {
+            const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+            if constexpr (copy) {
+                _mm_storeu_si128(reinterpret_cast<__m128i *>(dest + i), block);
+            }
+            lanes = _mm_add_epi32(lanes, _mm_unpacklo_epi16(block, zero));
+            lanes = _mm_add_epi32(lanes, _mm_unpackhi_epi16(block, zero));
+        }
+        array<uint32_t, 4> lane_sums{};
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(lane_sums.data()), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return sum + sum_words_scalar<copy>(data + vector_len, copy ? dest + vector_len : nullptr, len - vector_len);
+}
+
+//! \details The same as sum_words_sse2(), 32 bytes at a time.
+template <bool copy>
+__attribute__((target("avx2"))) static uint64_t sum_words_avx2(const char *data, char *dest, const size_t len) {
+    const __m256i zero = _mm256_setzero_si256();
+    const size_t vector_len = len - len % sizeof(__m256i);
+    uint64_t sum = 0;
+    for (size_t chunk = 0; chunk < vector_len; chunk += VECTOR_CHUNK) {
+        const size_t chunk_end = min(vector_len, chunk + VECTOR_CHUNK);
+        __m256i lanes = zero;
+        for (size_t i = chunk; i < chunk_end; i += sizeof(__m256i)) {
+            const __m256i block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+            if constexpr (copy) {
+                _mm256_storeu_si256(reinterpret_cast<__m256i *>(dest + i), block);
+            }
+            lanes = _mm256_add_epi32(lanes, _mm256_unpacklo_epi16(block, zero));
+            lanes = _mm256_add_epi32(lanes, _mm256_unpackhi_epi16(block, zero));
+        }
+        array<uint32_t, 8> lane_sums{};
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(lane_sums.data()), lanes);
+        for (const uint32_t lane_sum : lane_sums) {
+            sum += lane_sum;
+        }
+    }
+    return sum + sum_words_scalar<copy>(data + vector_len, copy ? dest + vector_len : nullptr, len - vector_len);
+}
+#endif  // SPONGE_X86_CHECKSUM_KERNELS
+
+bool InternetChecksum::supported(const Kernel kernel) {
+    switch (kernel) {
+        case Kernel::Auto:
+        case Kernel::Scalar:
+            return true;
+#ifdef SPONGE_X86_CHECKSUM_KERNELS
+        case Kernel::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case Kernel::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
 //! \note This class returns the checksum in host byte order.
 //!       See https://commandcenter.blogspot.com/2012/04/byte-order-fallacy.html for rationale
 //! \details This class can be used to either check or compute an Internet checksum
@@ -84,27 +198,80 @@ mt19937 get_random_generator() {
 //!
 //! For more information, see the [Wikipedia page](https://en.wikipedia.org/wiki/IPv4_header_checksum)
 //! on the Internet checksum, and consult the [IP](\ref rfc::rfc791) and [TCP](\ref rfc::rfc793) RFCs.
-InternetChecksum::InternetChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+//!
+//! \param[in] initial_sum is a sum to start from, e.g. the pseudo-header checksum of the lower layer
+//! \param[in] kernel is the implementation to use; they differ only in speed
+InternetChecksum::InternetChecksum(const uint32_t initial_sum, const Kernel kernel)
+    : _sum(initial_sum), _sum_words(sum_words_scalar<false>), _copy_and_sum_words(sum_words_scalar<true>) {
+    if (not supported(kernel)) {
+        throw runtime_error("InternetChecksum: this CPU does not support the requested kernel");
+    }
+#ifdef SPONGE_X86_CHECKSUM_KERNELS
+    static const bool has_avx2 = supported(Kernel::AVX2);
+    static const bool has_sse2 = supported(Kernel::SSE2);
+    if (kernel == Kernel::AVX2 or (kernel == Kernel::Auto and has_avx2)) {
+        _sum_words = sum_words_avx2<false>;
+        _copy_and_sum_words = sum_words_avx2<true>;
+    } else if (kernel == Kernel::SSE2 or (kernel == Kernel::Auto and has_sse2)) {
+        _sum_words = sum_words_sse2<false>;
+        _copy_and_sum_words = sum_words_sse2<true>;
+    }
+#endif
+}
 
-void InternetChecksum::add(std::string_view data) {
-    for (size_t i = 0; i < data.size(); i++) {
-        uint16_t val = uint8_t(data[i]);
-        if (not _parity) {
-            val <<= 8;
+//! \details Bytes at even offsets (counting all the data added so far) are the high bytes of 16-bit words.
+//! Ones' complement addition doesn't care about byte order as long as it's consistent, so the kernel adds
+//! the words in host byte order, and the folded result is swapped into network byte order once.
+void InternetChecksum::add(const string_view data) { _add(data, nullptr); }
+
+//! \param[in] data is the data to add
+//! \param[out] dest is where to copy it, with room for `data.size()` bytes
+void InternetChecksum::add_and_copy(const string_view data, char *dest) { _add(data, dest); }
+
+void InternetChecksum::_add(string_view data, char *dest) {
+    // finish the word whose high byte ended the previous data
+    if (_parity and not data.empty()) {
+        _sum += uint8_t(data.front());
+        if (dest) {
+            *dest++ = data.front();
         }
-        _sum += val;
-        _parity = !_parity;
+        data.remove_prefix(1);
+        _parity = false;
+    }
+
+    const size_t even_len = data.size() - data.size() % 2;
+    uint16_t words = fold(dest ? _copy_and_sum_words(data.data(), dest, even_len)
+                               : _sum_words(data.data(), nullptr, even_len));
+#if __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__
+    words = (words << 8) | (words >> 8);
+#endif
+    _sum += words;
+
+    // an odd byte at the end is the high byte of a word that the next data finishes
+    if (even_len < data.size()) {
+        _sum += uint16_t(uint8_t(data.back())) << 8;
+        if (dest) {
+            dest[even_len] = data.back();
+        }
+        _parity = true;
     }
 }
 
 uint16_t InternetChecksum::value() const {
-    uint32_t ret = _sum;
+    return ~fold(_sum);
+}
 
-    while (ret > 0xffff) {
-        ret = (ret >> 16) + (ret & 0xffff);
-    }
+uint16_t InternetChecksum::partial_sum() const {
+    return fold(_sum);
+}
 
-    return ~ret;
+//! \details Eqn. 3 of RFC 1624: HC' = ~(~HC + ~m + m'), once for each 16-bit half of the field.
+//! A 16-bit field has two zero upper halves, and adding ~0 + 0 is adding (negative) zero.
+uint16_t InternetChecksum::adjust(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value) {
+    uint64_t sum = uint16_t(~checksum);
+    sum += uint16_t(~(old_value >> 16)) + uint16_t(~old_value);
+    sum += (new_value >> 16) + (new_value & 0xffff);
+    return ~fold(sum);
 }
 
 //! \param[in] data is a pointer to the bytes to show
@@ -9,6 +9,7 @@
 #include <ostream>
 #include <random>
 #include <string>
+#include <string_view>
 #include <system_error>
 #include <vector>
 
@@ -53,14 +54,46 @@ uint64_t timestamp_ms();
 
 //! The internet checksum algorithm
 class InternetChecksum {
+  public:
+    //! Ways to add up the 16-bit words of the data; they all give the same checksum
+    enum class Kernel {
+        Auto,    //!< The fastest kernel that this CPU supports
+        Scalar,  //!< Portable, eight bytes at a time
+        SSE2,    //!< x86 SSE2, 16 bytes at a time
+        AVX2     //!< x86 AVX2, 32 bytes at a time
+    };
+
+    //! \returns `true` if this CPU can run `kernel`
+    static bool supported(const Kernel kernel);
+
   private:
-    uint32_t _sum;
+    //! Adds up an even number of bytes as 16-bit words in host byte order, into a 64-bit partial sum,
+    //! and may copy them to `dest` on the way
+    using WordSum = uint64_t (*)(const char *data, char *dest, const size_t len);
+
+    uint64_t _sum;
     bool _parity{};
+    WordSum _sum_words;
+    WordSum _copy_and_sum_words;
+
+    void _add(std::string_view data, char *dest);
 
   public:
-    InternetChecksum(const uint32_t initial_sum = 0);
-    void add(std::string_view data);
+    InternetChecksum(const uint32_t initial_sum = 0, const Kernel kernel = Kernel::Auto);
+    void add(const std::string_view data);
+
+    //! \brief Add `data` while copying it to `dest`, reading it from memory only once
+    void add_and_copy(const std::string_view data, char *dest);
     uint16_t value() const;
+
+    //! \brief The sum of the data so far, folded to 16 bits but not complemented
+    //! \details It can be the `initial_sum` of another InternetChecksum that carries on where this one left off,
+    //! as long as an even number of bytes has been added.
+    uint16_t partial_sum() const;
+
+    //! \brief Update `checksum` for a 16- or 32-bit field that changed from `old_value` to `new_value` (RFC 1624)
+    //! \note The field must start at an even offset in the checksummed data
+    static uint16_t adjust(const uint16_t checksum, const uint32_t old_value, const uint32_t new_value);
 };
 
 //! Hexdump the contents of a packet (or any other sequence of bytes)
@@ -0,0 +1,70 @@
+#include "byte_stream.hh"
+#include "packet_buffer.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // read_view() pops only what it returns, which is at most two chunks
+        {
+            ByteStream stream{64, ByteStream::Storage::Chunked};
+            stream.write(string("aaaa"));
+            stream.write(string("bbbb"));
+            stream.write(string("cccc"));
+
+            const auto [first, second] = stream.read_view(12);
+            test_should_be(first == "aaaa", true);
+            test_should_be(second == "bbbb", true);
+            test_should_be(stream.bytes_read(), size_t{8});
+            test_should_be(stream.buffer_size(), size_t{4});
+
+            // the popped chunks stay alive, so new packets don't get their blocks
+            vector<PacketBuffer> others;
+            for (size_t i = 0; i < 16; i++) {
+                others.emplace_back(string_view{"xxxx"});
+            }
+            test_should_be(first == "aaaa", true);
+            test_should_be(second == "bbbb", true);
+
+            const auto [rest, none] = stream.read_view(12);
+            test_should_be(rest == "cccc", true);
+            test_should_be(none.empty(), true);
+            test_should_be(stream.bytes_read(), size_t{12});
+            test_should_be(stream.buffer_empty(), true);
+        }
+
+        // reading a view at a time gets every byte, in order, including from partly read chunks
+        {
+            ByteStream stream{64, ByteStream::Storage::Chunked};
+            string written;
+            for (const string chunk : {"one", "two", "three", "four", "five"}) {
+                stream.write(chunk);
+                written += chunk;
+            }
+
+            string read;
+            const auto [partial, empty] = stream.read_view(2);
+            test_should_be(partial == "on", true);
+            test_should_be(empty.empty(), true);
+            read.append(partial);
+            while (not stream.buffer_empty()) {
+                const auto [first, second] = stream.read_view(written.size());
+                read.append(first).append(second);
+            }
+            test_should_be(read == written, true);
+            test_should_be(stream.bytes_read(), written.size());
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,212 @@
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! The byte-at-a-time InternetChecksum that the word-at-a-time kernels replaced
+class ReferenceChecksum {
+    uint64_t _sum;
+    bool _parity{};
+
+  public:
+    explicit ReferenceChecksum(const uint32_t initial_sum) : _sum(initial_sum) {}
+
+    void add(const string_view data) {
+        for (const char c : data) {
+            uint16_t val = uint8_t(c);
+            if (not _parity) {
+                val <<= 8;
+            }
+            _sum += val;
+            _parity = !_parity;
+        }
+    }
+
+    uint16_t value() const {
+        uint64_t ret = _sum;
+        while (ret > 0xffff) {
+            ret = (ret >> 16) + (ret & 0xffff);
+        }
+        return ~ret;
+    }
+};
+
+//! Check one kernel against the reference, adding `data` in the pieces that `cuts` marks, with and without copying
+void check(const InternetChecksum::Kernel kernel,
+           const string &kernel_name,
+           const uint32_t initial_sum,
+           const string_view data,
+           const vector<size_t> &cuts) {
+    InternetChecksum checksum{initial_sum, kernel};
+    InternetChecksum copying_checksum{initial_sum, kernel};
+    ReferenceChecksum reference{initial_sum};
+    string copy(data.size(), 0);
+    size_t begin = 0;
+    for (size_t i = 0; i <= cuts.size(); i++) {
+        const size_t end = i < cuts.size() ? cuts[i] : data.size();
+        checksum.add(data.substr(begin, end - begin));
+        copying_checksum.add_and_copy(data.substr(begin, end - begin), copy.data() + begin);
+        reference.add(data.substr(begin, end - begin));
+        begin = end;
+    }
+
+    if (checksum.value() != reference.value() or copying_checksum.value() != reference.value()) {
+        ostringstream ss;
+        ss << "The " << kernel_name << " kernel gave checksum " << checksum.value() << " (" << copying_checksum.value()
+           << " while copying) instead of " << reference.value() << " for " << data.size() << " bytes in "
+           << cuts.size() + 1 << " pieces, with initial sum " << initial_sum;
+        throw runtime_error(ss.str());
+    }
+    if (copy != data) {
+        throw runtime_error("The " + kernel_name + " kernel copied the data wrong");
+    }
+}
+
+//! Write `value` into `data` at `offset` in network byte order, `size` bytes wide
+static void put(string &data, const size_t offset, const size_t size, const uint32_t value) {
+    for (size_t i = 0; i < size; i++) {
+        data[offset + i] = static_cast<char>(value >> (8 * (size - 1 - i)));
+    }
+}
+
+//! Read a `size`-byte value from `data` at `offset` in network byte order
+static uint32_t get(const string &data, const size_t offset, const size_t size) {
+    uint32_t value = 0;
+    for (size_t i = 0; i < size; i++) {
+        value = (value << 8) | uint8_t(data[offset + i]);
+    }
+    return value;
+}
+
+static uint16_t checksum_of(const string_view data) {
+    InternetChecksum check;
+    check.add(data);
+    return check.value();
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        const vector<pair<InternetChecksum::Kernel, string>> kernels{{InternetChecksum::Kernel::Auto, "auto"},
+                                                                     {InternetChecksum::Kernel::Scalar, "scalar"},
+                                                                     {InternetChecksum::Kernel::SSE2, "SSE2"},
+                                                                     {InternetChecksum::Kernel::AVX2, "AVX2"}};
+
+        // random bytes at random alignments, added in random pieces
+        string buffer(1 << 17, 0);
+        for (auto &c : buffer) {
+            c = static_cast<char>(rd());
+        }
+        for (unsigned int i = 0; i < 4000; i++) {
+            const size_t offset = uniform_int_distribution<size_t>{0, 63}(rd);
+            const size_t max_len = i % 2 ? 256 : 70'000;
+            const size_t len = uniform_int_distribution<size_t>{0, max_len}(rd);
+            const string_view data = string_view{buffer}.substr(offset, len);
+            const uint32_t initial_sum = uniform_int_distribution<uint32_t>{0, 0x3'ffff}(rd);
+
+            vector<size_t> cuts(uniform_int_distribution<size_t>{0, 4}(rd));
+            for (auto &cut : cuts) {
+                cut = uniform_int_distribution<size_t>{0, len}(rd);
+            }
+            sort(cuts.begin(), cuts.end());
+
+            for (const auto &[kernel, name] : kernels) {
+                if (InternetChecksum::supported(kernel)) {
+                    check(kernel, name, initial_sum, data, cuts);
+                }
+            }
+        }
+
+        // sums that come close to overflowing the kernels' accumulators
+        for (const char fill : {'\x00', '\xff'}) {
+            for (const size_t len : {size_t{65'536}, size_t{1} << 20, (size_t{1} << 20) + 31}) {
+                const string data(len, fill);
+                for (const auto &[kernel, name] : kernels) {
+                    if (InternetChecksum::supported(kernel)) {
+                        check(kernel, name, 0, data, {});
+                        check(kernel, name, 0xffff, data, {1});
+                    }
+                }
+            }
+        }
+
+        // checksums updated for a changed field match checksums computed from scratch
+        for (unsigned int i = 0; i < 4000; i++) {
+            string data = buffer.substr(0, uniform_int_distribution<size_t>{4, 64}(rd) * 2);
+            const size_t size = i % 2 ? 2 : 4;
+            const size_t offset = uniform_int_distribution<size_t>{0, (data.size() - size) / 2}(rd) * 2;
+            const uint16_t before = checksum_of(data);
+            const uint32_t old_value = get(data, offset, size);
+            const uint32_t new_value = i % 8 < 2 ? 0 : static_cast<uint32_t>(rd()) >> (32 - 8 * size);
+            put(data, offset, size, new_value);
+            test_should_be(InternetChecksum::adjust(before, old_value, new_value), checksum_of(data));
+        }
+
+        // a partial sum carries on into another checksum
+        for (unsigned int i = 0; i < 1000; i++) {
+            const string_view data = string_view{buffer}.substr(0, uniform_int_distribution<size_t>{0, 3000}(rd));
+            const size_t split = uniform_int_distribution<size_t>{0, data.size() / 2}(rd) * 2;
+            InternetChecksum first;
+            first.add(data.substr(0, split));
+            InternetChecksum second{first.partial_sum()};
+            second.add(data.substr(split));
+            test_should_be(second.value(), checksum_of(data));
+        }
+
+        // a segment keeps its payload's sum across header changes, but not across payload changes
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(static_cast<uint32_t>(rd()));
+            seg.set_payload(buffer.substr(0, 1451));
+            const uint32_t pseudo_sum = uniform_int_distribution<uint32_t>{0, 0x3'ffff}(rd);
+            for (unsigned int i = 0; i < 3; i++) {
+                seg.header().ackno = WrappingInt32(static_cast<uint32_t>(rd()));
+                seg.header().win = static_cast<uint16_t>(rd());
+                if (i == 2) {
+                    seg.set_payload(buffer.substr(1, 777));
+                }
+                const string raw = seg.serialize(pseudo_sum).concatenate();
+                InternetChecksum check{pseudo_sum};
+                check.add(raw);
+                test_should_be(check.value(), uint16_t{0});
+
+                TCPSegment parsed;
+                test_should_be(parsed.parse(string(raw), pseudo_sum) == ParseResult::NoError, true);
+                test_should_be(parsed.payload().copy() == seg.payload().copy(), true);
+                test_should_be(parsed.serialize(pseudo_sum).concatenate() == raw, true);
+
+                // serializing into a packet buffer gives the same bytes, whether the payload's sum is known or not
+                string packet = "prefix";
+                TCPSegment unsummed;
+                unsummed.header() = seg.header();
+                unsummed.set_payload(seg.payload());
+                unsummed.serialize_into(packet, pseudo_sum);
+                test_should_be(packet == "prefix" + raw, true);
+                packet.clear();
+                unsummed.serialize_into(packet, pseudo_sum);
+                test_should_be(packet == raw, true);
+                test_should_be(parsed.parse(string(raw), pseudo_sum + 1) == ParseResult::BadChecksum, true);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
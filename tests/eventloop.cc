@@ -0,0 +1,179 @@
+#include "eventloop.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+
+using namespace std;
+
+//! A connected pair of local stream sockets
+static pair<LocalStreamSocket, LocalStreamSocket> socket_pair() {
+    array<int, 2> fds{};
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+    return {LocalStreamSocket{FileDescriptor(fds[0])}, LocalStreamSocket{FileDescriptor(fds[1])}};
+}
+
+//! Check that all the backends behave the same way
+static void check(const EventLoop::Backend backend) {
+    using Result = EventLoop::Result;
+
+    // a readable fd is serviced until its peer hangs up, and then the rule is canceled
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        string received;
+        bool canceled = false;
+        loop.add_rule(
+            a, Direction::In, [&] { received += a.read(); }, [] { return true; }, [&] { canceled = true; });
+
+        test_should_be(loop.wait_next_event(0) == Result::Timeout, true);
+        b.write("hello");
+        test_should_be(loop.wait_next_event(0) == Result::Success, true);
+        test_should_be(received == "hello", true);
+
+        b.close();
+        test_should_be(loop.wait_next_event(0) == Result::Success, true);
+        test_should_be(a.eof(), true);
+        test_should_be(canceled, false);
+        test_should_be(loop.wait_next_event(0) == Result::Exit, true);
+        test_should_be(canceled, true);
+    }
+
+    // a rule is only waited on while it is interested, and rules in both directions share an fd
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool want_to_write = false;
+        size_t reads = 0, writes = 0;
+        loop.add_rule(a, Direction::In, [&] {
+            a.read();
+            reads++;
+        });
+        loop.add_rule(
+            a,
+            Direction::Out,
+            [&] {
+                a.write("x");
+                writes++;
+                want_to_write = false;
+            },
+            [&] { return want_to_write; });
+
+        test_should_be(loop.wait_next_event(0) == Result::Timeout, true);
+        want_to_write = true;
+        test_should_be(loop.wait_next_event(0) == Result::Success, true);
+        test_should_be(writes, size_t{1});
+        test_should_be(loop.wait_next_event(0) == Result::Timeout, true);
+        test_should_be(writes, size_t{1});
+
+        b.write("y");
+        want_to_write = true;
+        test_should_be(loop.wait_next_event(0) == Result::Success, true);
+        test_should_be(reads, size_t{1});
+        test_should_be(writes, size_t{2});
+        test_should_be(b.read() == "xx", true);
+    }
+
+    // nothing interested means nothing to wait for
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        loop.add_rule(
+            a, Direction::In, [&] { a.read(); }, [] { return false; });
+        test_should_be(loop.wait_next_event(0) == Result::Exit, true);
+    }
+
+    // a callback that leaves its fd ready, and stays interested, is a busy wait
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        loop.add_rule(a, Direction::In, [] {});
+        b.write("ignored");
+        try {
+            loop.wait_next_event(0);
+            throw runtime_error("busy wait not detected");
+        } catch (const runtime_error &e) {
+            test_should_be(string(e.what()).find("busy wait") != string::npos, true);
+        }
+    }
+
+    // a rule whose fd is closed behind its back is canceled before long
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(
+            a, Direction::In, [&] { a.read(); }, [] { return true; }, [&] { canceled = true; });
+        loop.add_rule(b, Direction::In, [&] { b.read(); });
+        a.close();
+        for (unsigned int i = 0; i < 2 and not canceled; i++) {
+            loop.wait_next_event(0);
+        }
+        test_should_be(canceled, true);
+
+        // and its fd number can be used again
+        auto [c, d] = socket_pair();
+        string received;
+        loop.add_rule(c, Direction::In, [&] { received += c.read(); });
+        d.write("again");
+        test_should_be(loop.wait_next_event(0) == Result::Success, true);
+        test_should_be(received == "again", true);
+    }
+
+    // a canceled rule may hold the last reference to its fd, which has to stay open until it's unregistered
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        auto reader = make_shared<LocalStreamSocket>(move(a));
+        bool canceled = false;
+        loop.add_rule(
+            *reader, Direction::In, [reader] { reader->read(); }, [] { return true; }, [&] { canceled = true; });
+        reader.reset();
+        b.close();
+        while (loop.wait_next_event(0) != Result::Exit) {
+        }
+        test_should_be(canceled, true);
+    }
+
+    // an fd closed behind the back of its rules isn't registered again, even if one of them is still interested
+    {
+        EventLoop loop{backend};
+        auto [a, b] = socket_pair();
+        bool canceled = false;
+        loop.add_rule(a, Direction::In, [&] { a.read(); });
+        loop.add_rule(
+            a, Direction::Out, [&] { a.write("x"); }, [] { return false; }, [&] { canceled = true; });
+        test_should_be(loop.wait_next_event(0) == Result::Timeout, true);
+        a.close();
+        for (unsigned int i = 0; i < 3; i++) {
+            loop.wait_next_event(0);
+        }
+        test_should_be(canceled, true);
+    }
+}
+
+int main() {
+    try {
+        check(EventLoop::Backend::Poll);
+        check(EventLoop::Backend::Epoll);
+        check(EventLoop::Backend::IoUring);
+
+        // io_uring is used if it's there, and epoll if not
+        const auto expected = IoUring::available() ? EventLoop::Backend::IoUring : EventLoop::Backend::Epoll;
+        test_should_be(EventLoop{EventLoop::Backend::IoUring}.backend() == expected, true);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
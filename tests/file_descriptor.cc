@@ -0,0 +1,85 @@
+#include "file_descriptor.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <sys/socket.h>
+
+using namespace std;
+
+int main() {
+    try {
+        // each read hands back exactly the bytes read, whichever way it's done
+        {
+            array<int, 2> fds{};
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_DGRAM, 0, fds.data()));
+            FileDescriptor reader{fds[0]}, writer{fds[1]};
+
+            writer.write(string(1500, 'a'));
+            string str = reader.read();
+            test_should_be(str == string(1500, 'a'), true);
+            test_should_be(str.capacity() < size_t{4096}, true);
+
+            writer.write("bb");
+            reader.read(str);
+            test_should_be(str == "bb", true);
+
+            writer.write(string(1500, 'c'));
+            const Buffer pooled = reader.read_buffer();
+            test_should_be(pooled.str() == string(1500, 'c'), true);
+
+            writer.write("dddd");
+            const Buffer limited = reader.read_buffer(2);
+            test_should_be(limited.str() == "dd", true);
+
+            writer.write("eeeee");
+            const PacketBuffer provided{64};
+            const Buffer into = reader.read_buffer(provided);
+            test_should_be(into.str() == "eeeee", true);
+            test_should_be(into.str().data() == provided.data(), true);
+
+            test_should_be(reader.read_count(), 5u);
+            test_should_be(reader.eof(), false);
+        }
+
+        // EOF is noticed
+        {
+            array<int, 2> fds{};
+            SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+            FileDescriptor reader{fds[0]}, writer{fds[1]};
+            writer.close();
+            test_should_be(reader.read_buffer().size(), size_t{0});
+            test_should_be(reader.eof(), true);
+        }
+
+        // a UDP datagram comes with its sender, and keeps its pooled block only if it needs it
+        {
+            UDPSocket receiver, sender;
+            receiver.bind({"127.0.0.1", 0});
+            sender.connect(receiver.local_address());
+
+            sender.send("hello");
+            const auto datagram = receiver.recv_buffer();
+            test_should_be(datagram.payload.str() == "hello", true);
+            test_should_be(datagram.source_address.port(), sender.local_address().port());
+
+            sender.send(string(1500, 'x'));
+            auto reused = receiver.recv();
+            test_should_be(reused.payload == string(1500, 'x'), true);
+            sender.send("again");
+            receiver.recv(reused);
+            test_should_be(reused.payload == "again", true);
+            test_should_be(reused.source_address.port(), sender.local_address().port());
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,111 @@
+#include "io_uring.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <array>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <poll.h>
+#include <string>
+#include <sys/socket.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+//! A connected pair of local stream sockets
+static pair<LocalStreamSocket, LocalStreamSocket> socket_pair() {
+    array<int, 2> fds{};
+    SystemCall("socketpair", ::socketpair(AF_UNIX, SOCK_STREAM, 0, fds.data()));
+    return {LocalStreamSocket{FileDescriptor(fds[0])}, LocalStreamSocket{FileDescriptor(fds[1])}};
+}
+
+int main() {
+    try {
+        if (not IoUring::available()) {
+            cerr << "io_uring is not available; skipping\n";
+            return EXIT_SUCCESS;
+        }
+
+        // reads and writes go through the buffers, and keep the FileDescriptor's counts and EOF flag
+        {
+            IoUring ring{8, 4, 4096};
+            test_should_be(ring.free_buffers(), size_t{4});
+            auto [a, b] = socket_pair();
+
+            test_should_be(ring.write(a, string("hello"), 1), true);
+            auto completions = ring.submit(1);
+            test_should_be(completions.size(), size_t{1});
+            test_should_be(completions[0].user_data, uint64_t{1});
+            test_should_be(completions[0].result, 5);
+            test_should_be(a.write_count(), 1u);
+
+            test_should_be(ring.read(b, 2), true);
+            test_should_be(ring.free_buffers(), size_t{3});
+            completions = ring.submit(1);
+            test_should_be(completions.size(), size_t{1});
+            test_should_be(completions[0].user_data, uint64_t{2});
+            test_should_be(completions[0].data == "hello", true);
+            test_should_be(b.read_count(), 1u);
+            test_should_be(b.eof(), false);
+
+            // the data stays in its buffer until the next submit
+            test_should_be(ring.free_buffers(), size_t{3});
+            a.close();
+            test_should_be(ring.read(b, 3), true);
+            completions = ring.submit(1);
+            test_should_be(ring.free_buffers(), size_t{4});
+            test_should_be(completions[0].result, 0);
+            test_should_be(b.eof(), true);
+        }
+
+        // many reads, from many sockets, in one submit
+        {
+            constexpr size_t SOCKETS = 16;
+            IoUring ring{8, SOCKETS, 1500};
+            vector<UDPSocket> receivers(SOCKETS), senders(SOCKETS);
+            for (size_t i = 0; i < SOCKETS; i++) {
+                receivers[i].bind({"127.0.0.1", 0});
+                senders[i].connect(receivers[i].local_address());
+                test_should_be(ring.write(senders[i], "datagram " + to_string(i), i), true);
+            }
+            test_should_be(ring.submit(SOCKETS).size(), SOCKETS);
+
+            for (size_t i = 0; i < SOCKETS; i++) {
+                test_should_be(ring.read(receivers[i], i), true);
+            }
+            test_should_be(ring.read(receivers[0], 0), false);
+            test_should_be(ring.in_flight(), SOCKETS);
+            const auto &completions = ring.submit(SOCKETS);
+            test_should_be(completions.size(), SOCKETS);
+            for (const auto &completion : completions) {
+                test_should_be(completion.data == "datagram " + to_string(completion.user_data), true);
+            }
+            test_should_be(ring.in_flight(), size_t{0});
+        }
+
+        // a poll finishes when its fd is ready, and a canceled one never does
+        {
+            IoUring ring{};
+            auto [a, b] = socket_pair();
+            const uint64_t in = ring.poll(a.fd_num(), POLLIN, 1);
+            ring.poll(a.fd_num(), POLLOUT, 2);
+            auto completions = ring.submit(1);
+            test_should_be(completions.size(), size_t{1});
+            test_should_be(completions[0].user_data, uint64_t{2});
+            test_should_be(completions[0].result & POLLOUT, POLLOUT);
+
+            ring.cancel_poll(in);
+            b.write("x");
+            test_should_be(ring.submit(1, 10).empty(), true);
+            test_should_be(ring.in_flight(), size_t{0});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
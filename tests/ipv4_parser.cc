@@ -217,7 +217,7 @@ int main(int argc, char **argv) {
 
             IPv4Datagram ip_dgram_copy;
             TCPSegment tcp_seg_copy;
-            tcp_seg_copy.payload() = tcp_seg.payload();
+            tcp_seg_copy.set_payload(tcp_seg.payload());
 
             // set headers in new packets, and fix up to remove extensions
             {
@@ -0,0 +1,117 @@
+#include "buffer.hh"
+#include "packet_buffer.hh"
+#include "test_should_be.hh"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // a packet holds what is copied into it, and shares it with its copies
+        {
+            const PacketBuffer packet{string_view{"hello, world"}};
+            test_should_be(packet.size(), size_t{12});
+            test_should_be(packet.capacity(), PacketBuffer::MIN_POOLED_SIZE);
+            test_should_be(packet.str() == "hello, world", true);
+
+            Buffer buffer{packet};
+            buffer.remove_prefix(7);
+            test_should_be(buffer.str() == "world", true);
+            test_should_be(packet.data() + 7 == buffer.str().data(), true);
+            buffer.remove_suffix(5);
+            test_should_be(buffer.size(), size_t{0});
+            test_should_be(packet.str() == "hello, world", true);
+        }
+
+        // a block whose last reference is gone is reused by the next packet of its size class
+        {
+            const char *first_data = nullptr;
+            {
+                PacketBuffer packet{1452};
+                test_should_be(packet.capacity(), size_t{2048});
+                first_data = packet.data();
+                PacketBuffer copy = packet;
+                packet = PacketBuffer{};
+                test_should_be(copy.data() == first_data, true);
+            }
+            const size_t pooled = PacketBuffer::pooled_blocks();
+            test_should_be(pooled > 0, true);
+
+            PacketBuffer packet{1500};
+            test_should_be(packet.data() == first_data, true);
+            test_should_be(PacketBuffer::pooled_blocks(), pooled - 1);
+
+            packet.resize(2048);
+            test_should_be(packet.size(), size_t{2048});
+            try {
+                packet.resize(2049);
+                throw runtime_error("resize() beyond the capacity should have failed");
+            } catch (const length_error &) {
+            }
+        }
+
+        // packets too big for the pool are allocated and freed directly
+        {
+            const size_t pooled = PacketBuffer::pooled_blocks();
+            {
+                PacketBuffer packet{PacketBuffer::MAX_POOLED_SIZE + 1};
+                test_should_be(packet.capacity(), PacketBuffer::MAX_POOLED_SIZE + 1);
+            }
+            test_should_be(PacketBuffer::pooled_blocks(), pooled);
+        }
+
+        // a short packet in a big block moves to a block that fits it
+        {
+            PacketBuffer packet{PacketBuffer::MAX_POOLED_SIZE};
+            memcpy(packet.data(), "short", 5);
+            packet.resize(5);
+            packet.shrink_to_fit();
+            test_should_be(packet.capacity(), PacketBuffer::MIN_POOLED_SIZE);
+            test_should_be(packet.str() == "short", true);
+
+            PacketBuffer full{1500};
+            full.shrink_to_fit();
+            test_should_be(full.capacity(), size_t{2048});
+        }
+
+        // the free lists don't grow without bound
+        {
+            vector<PacketBuffer> packets;
+            for (unsigned int i = 0; i < 1000; i++) {
+                packets.emplace_back(PacketBuffer::MAX_POOLED_SIZE);
+            }
+            packets.clear();
+            test_should_be(PacketBuffer::pooled_blocks() < 100, true);
+        }
+
+        // a packet can be released by another thread, onto that thread's free lists
+        {
+            vector<PacketBuffer> packets;
+            for (unsigned int i = 0; i < 100; i++) {
+                packets.emplace_back(string_view{"data"});
+            }
+            thread other{[moved = move(packets)]() mutable {
+                for (const auto &packet : moved) {
+                    if (packet.str() != "data") {
+                        throw runtime_error("packet changed on the way to another thread");
+                    }
+                }
+                moved.clear();
+            }};
+            other.join();
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
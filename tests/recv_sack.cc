@@ -0,0 +1,132 @@
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Serialize a segment and parse it back, as if it had crossed the network
+static TCPSegment reparse(const TCPSegment &seg) {
+    TCPSegment ret;
+    if (const auto res = ret.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+        throw runtime_error("parse failure: " + as_string(res));
+    }
+    return ret;
+}
+
+static TCPSegment data_segment(const WrappingInt32 seqno, const string &data) {
+    TCPSegment seg;
+    seg.header().seqno = seqno;
+    seg.set_payload(string(data));
+    return seg;
+}
+
+static void check_blocks(const vector<SACKBlock> &actual, const vector<SACKBlock> &expected) {
+    if (actual == expected) {
+        return;
+    }
+    ostringstream ss;
+    ss << "SACK blocks should have been";
+    for (const auto &block : expected) {
+        ss << " [" << block.left << ", " << block.right << ")";
+    }
+    ss << ", but they were";
+    for (const auto &block : actual) {
+        ss << " [" << block.left << ", " << block.right << ")";
+    }
+    throw runtime_error(ss.str());
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // a SYN from a sender that offers SACK permits SACK blocks at the receiver
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.sack = true;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            const TCPSegment syn = reparse(sender.segments_out().front());
+            test_should_be(syn.header().syn, true);
+            test_should_be(syn.header().sack_permitted, true);
+            test_should_be(syn.header().doff, uint8_t{7});  // with the MSS option
+
+            TCPReceiver receiver{4000};
+            receiver.segment_received(syn);
+            test_should_be(receiver.sack_permitted(), true);
+            check_blocks(receiver.sack_blocks(), {});
+
+            // out-of-order data: the latest block first, then the others from the highest down
+            receiver.segment_received(data_segment(isn + 3, "c"));
+            receiver.segment_received(data_segment(isn + 7, "g"));
+            receiver.segment_received(data_segment(isn + 5, "e"));
+            check_blocks(receiver.sack_blocks(), {{isn + 5, isn + 6}, {isn + 7, isn + 8}, {isn + 3, isn + 4}});
+
+            // held substrings that touch make a single block
+            receiver.segment_received(data_segment(isn + 4, "d"));
+            check_blocks(receiver.sack_blocks(), {{isn + 3, isn + 6}, {isn + 7, isn + 8}});
+
+            // the blocks survive the trip through the header
+            TCPSegment ack;
+            ack.header().ack = true;
+            ack.header().ackno = receiver.ackno().value();
+            ack.header().sack_blocks = receiver.sack_blocks();
+            ack.header().doff = (TCPHeader::LENGTH + ack.header().options_length()) / 4;
+            const TCPSegment ack_copy = reparse(ack);
+            check_blocks(ack_copy.header().sack_blocks, ack.header().sack_blocks);
+            test_should_be(ack_copy.header() == ack.header(), true);
+
+            // blocks at or below the ackno are no longer reported
+            receiver.segment_received(data_segment(isn + 1, "ab"));
+            test_should_be(receiver.ackno().value().raw_value(), (isn + 6).raw_value());
+            check_blocks(receiver.sack_blocks(), {{isn + 7, isn + 8}});
+        }
+
+        // without SACK-permitted on the SYN, the receiver never sends SACK blocks
+        {
+            const WrappingInt32 isn(rd());
+            TCPSegment syn;
+            syn.header().syn = true;
+            syn.header().seqno = isn;
+
+            TCPReceiver receiver{4000};
+            receiver.segment_received(reparse(syn));
+            test_should_be(receiver.sack_permitted(), false);
+            receiver.segment_received(data_segment(isn + 3, "c"));
+            test_should_be(receiver.unassembled_bytes(), size_t{1});
+            check_blocks(receiver.sack_blocks(), {});
+        }
+
+        // only the options that fit in `doff` are serialized, and at most four SACK blocks fit
+        {
+            TCPSegment seg;
+            for (uint32_t i = 0; i < 5; i++) {
+                seg.header().sack_blocks.push_back({WrappingInt32{10 * i}, WrappingInt32{10 * i + 5}});
+            }
+            check_blocks(reparse(seg).header().sack_blocks, {});
+
+            seg.header().doff = (TCPHeader::LENGTH + seg.header().options_length()) / 4;
+            test_should_be(seg.header().doff, uint8_t{14});
+            const vector<SACKBlock> first_four(seg.header().sack_blocks.begin(), seg.header().sack_blocks.begin() + 4);
+            check_blocks(reparse(seg).header().sack_blocks, first_four);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
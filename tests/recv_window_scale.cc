@@ -0,0 +1,139 @@
+#include "tcp_receiver.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Serialize a segment and parse it back, as if it had crossed the network
+static TCPSegment reparse(const TCPSegment &seg) {
+    TCPSegment ret;
+    if (const auto res = ret.parse(seg.serialize().concatenate()); res != ParseResult::NoError) {
+        throw runtime_error("parse failure: " + as_string(res));
+    }
+    return ret;
+}
+
+static TCPHeader syn_header(const WrappingInt32 isn, const optional<uint8_t> window_scale) {
+    TCPHeader header;
+    header.syn = true;
+    header.seqno = isn;
+    header.win = 1000;
+    header.window_scale = window_scale;
+    header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+    return header;
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // every option survives the trip through the header, as long as it fits
+        {
+            TCPSegment seg;
+            TCPHeader &header = seg.header();
+            header.mss = 1460;
+            header.window_scale = 7;
+            header.sack_permitted = true;
+            header.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            for (uint32_t i = 0; i < 4; i++) {
+                header.sack_blocks.push_back({WrappingInt32{10 * i}, WrappingInt32{10 * i + 5}});
+            }
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            test_should_be(header.doff, uint8_t{15});
+
+            // with the other options, only two SACK blocks fit
+            header.sack_blocks.erase(header.sack_blocks.begin() + 2, header.sack_blocks.end());
+            test_should_be(reparse(seg).header() == header, true);
+        }
+
+        // unknown options are skipped
+        {
+            string raw = syn_header(WrappingInt32(rd()), {}).serialize();
+            raw[12] = 7 << 4;  // make room for eight bytes of options
+            raw += string{30, 4, 0, 0};                          // an unknown option
+            raw += string{2, 4, 0x05, static_cast<char>(0xb4)};  // MSS 1460
+            NetParser p{Buffer{move(raw)}};
+            TCPHeader header;
+            test_should_be(header.parse(p) == ParseResult::NoError, true);
+            test_should_be(header.mss.value_or(0), uint16_t{1460});
+            test_should_be(header.window_scale.has_value(), false);
+        }
+
+        // the SYN announces the MSS and the window scale for the receive capacity
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.recv_capacity = 4'000'000;
+            cfg.window_scaling = true;
+            test_should_be(cfg.window_scale(), uint8_t{6});
+
+            TCPSender sender{cfg};
+            sender.fill_window();
+            const TCPSegment syn = reparse(sender.segments_out().front());
+            test_should_be(syn.header().mss.value_or(0), uint16_t{TCPConfig::MAX_PAYLOAD_SIZE});
+            test_should_be(syn.header().window_scale.value_or(0), uint8_t{6});
+
+            // a receiver that offers scaling too scales its window field, and the peer's
+            TCPReceiver receiver{cfg};
+            receiver.segment_received(syn);
+            test_should_be(receiver.window_size(), size_t{4'000'000});
+            test_should_be(receiver.window_field(), uint16_t{62'500});
+
+            TCPHeader ack;
+            ack.ack = true;
+            ack.win = 1000;
+            test_should_be(receiver.peer_window(ack), size_t{64'000});
+            test_should_be(receiver.peer_window(syn.header()), size_t{syn.header().win});
+        }
+
+        // without scaling on both SYNs, window fields are taken as they are
+        for (const bool ours : {false, true}) {
+            TCPConfig cfg;
+            cfg.recv_capacity = 4'000'000;
+            cfg.window_scaling = ours;
+            const WrappingInt32 isn(rd());
+
+            TCPReceiver receiver{cfg};
+            receiver.segment_received(reparse([&] {
+                TCPSegment syn;
+                syn.header() = syn_header(isn, ours ? optional<uint8_t>{} : optional<uint8_t>{3});
+                return syn;
+            }()));
+            test_should_be(receiver.window_field(), uint16_t{UINT16_MAX});
+
+            TCPHeader ack;
+            ack.ack = true;
+            ack.win = 1000;
+            test_should_be(receiver.peer_window(ack), size_t{1000});
+        }
+
+        // the sender fills a window beyond 64 KiB
+        {
+            TCPConfig cfg;
+            const WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.send_capacity = 1'000'000;
+            TCPSender sender{cfg};
+            sender.fill_window();
+            sender.ack_received(isn + 1, 200'000);
+            sender.stream_in().write(string(300'000, 'x'));
+            sender.fill_window();
+            test_should_be(sender.bytes_in_flight(), size_t{200'000});
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
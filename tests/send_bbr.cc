@@ -0,0 +1,76 @@
+#include "tcp_congestion_control.hh"
+#include "test_should_be.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <optional>
+
+using namespace std;
+
+using Mode = BBRCongestionController::Mode;
+
+static constexpr size_t MSS = 1000;
+
+//! Acknowledge one segment per millisecond, from `from_ms` to `to_ms`, with round-trip times from `rtt_ms`
+//! \returns when the controller first went into ProbeRTT, if it did
+static optional<uint64_t> run(BBRCongestionController &bbr,
+                              const uint64_t from_ms,
+                              const uint64_t to_ms,
+                              const function<uint64_t(uint64_t)> &rtt_ms) {
+    optional<uint64_t> probe_rtt_ms;
+    for (uint64_t now = from_ms; now < to_ms; now++) {
+        bbr.on_ack({MSS, bbr.window(), now, rtt_ms(now), false});
+        if (bbr.mode() == Mode::ProbeRTT and not probe_rtt_ms.has_value()) {
+            probe_rtt_ms = now;
+            test_should_be(bbr.window(), 4 * MSS);
+        }
+    }
+    return probe_rtt_ms;
+}
+
+int main() {
+    try {
+        // startup is slow start, capped at the high gain (2.885) times the bandwidth-delay product (20 segments
+        // here), where uncapped slow start would reach 90 segments by the time startup ends
+        {
+            BBRCongestionController bbr{MSS};
+            size_t largest = 0;
+            for (uint64_t now = 0; now < 1000; now++) {
+                bbr.on_ack({MSS, bbr.window(), now, 20, false});
+                if (bbr.mode() == Mode::Startup) {
+                    largest = max(largest, bbr.window());
+                }
+            }
+            test_should_be(largest > 2 * 20 * MSS, true);
+            test_should_be(largest < 70 * MSS, true);
+            test_should_be(bbr.mode() == Mode::ProbeBandwidth, true);
+        }
+
+        // steady samples don't keep the min-RTT filter fresh: ProbeRTT comes once its window expires
+        {
+            BBRCongestionController bbr{MSS};
+            const auto probe_rtt_ms = run(bbr, 0, 10'500, [](uint64_t) { return 20; });
+            test_should_be(probe_rtt_ms.has_value(), true);
+            test_should_be(*probe_rtt_ms > 10'000 and *probe_rtt_ms <= 10'001, true);
+
+            // and it ends after 200 ms and a round trip
+            run(bbr, 10'500, 10'600, [](uint64_t) { return 20; });
+            test_should_be(bbr.mode() == Mode::ProbeRTT, false);
+        }
+
+        // a round-trip time inflated by a queue doesn't quietly replace the true minimum either
+        {
+            BBRCongestionController bbr{MSS};
+            const auto probe_rtt_ms = run(bbr, 0, 10'500, [](const uint64_t now) { return now < 5000 ? 20 : 50; });
+            test_should_be(probe_rtt_ms.has_value(), true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,151 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Three duplicate ACKs trigger a fast retransmit", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 5}});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+
+            TCPSenderTestHarness test{"Duplicate ACKs wait for the timer without fast retransmit", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectSegment{}.with_data("b"));
+            for (unsigned i = 0; i < 2 * TCPConfig::DUPACK_THRESHOLD; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}});
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"Window updates are not duplicate ACKs", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(1000));
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectSegment{}.with_data("b"));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(999));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(998));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(997));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(997));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(997));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_win(997));
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.congestion_control = TCPConfig::CongestionControl::Reno;
+
+            TCPSenderTestHarness test{"Partial ACKs during fast recovery retransmit the next hole", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d", "e"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // "b" and "d" were lost
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            for (unsigned i = 0; i < TCPConfig::DUPACK_THRESHOLD; i++) {
+                test.execute(ExpectNoSegment{});
+                test.execute(AckReceived{WrappingInt32{isn + 2}});
+            }
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}});
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 6}});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+            test.execute(WriteBytes{"f"});
+            test.execute(ExpectSegment{}.with_data("f").with_seqno(isn + 6));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"No fast retransmit for data sent before a timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            for (unsigned i = 0; i < TCPConfig::DUPACK_THRESHOLD; i++) {
+                test.execute(AckReceived{WrappingInt32{isn + 1}});
+            }
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{2u * retx_timeout});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
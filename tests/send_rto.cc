@@ -0,0 +1,116 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rto_min = 1;
+
+            TCPSenderTestHarness test{"Adaptive RTO follows the measured RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{10});
+            // SRTT = 10, RTTVAR = 5, so RTO = 10 + 4 * 5
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(Tick{20});
+            test.execute(ExpectNoSegment{});
+            // SRTT = 7/8 * 10 + 1/8 * 20 = 11.25, RTTVAR = 3/4 * 5 + 1/4 * 10 = 6.25, so RTO = ceil(36.25)
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(WriteBytes{"b"});
+            test.execute(ExpectSegment{}.with_data("b"));
+            test.execute(Tick{36});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            // the ACK of a retransmitted segment isn't timed, and the RTO stays backed off (Karn's algorithm)
+            test.execute(AckReceived{WrappingInt32{isn + 3}});
+            test.execute(WriteBytes{"c"});
+            test.execute(ExpectSegment{}.with_data("c"));
+            test.execute(Tick{73});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("c").with_seqno(isn + 3));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+
+            TCPSenderTestHarness test{"Adaptive RTO is no less than rto_min", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{2});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(Tick{TCPConfig::RTO_MIN_DFLT - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.adaptive_rto = true;
+            cfg.rt_timeout = 100;
+            cfg.rto_max = 300;
+
+            TCPSenderTestHarness test{"Backed-off RTO is no more than rto_max", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{100});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            test.execute(Tick{200});
+            test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            for (unsigned attempt = 0; attempt < 3; attempt++) {
+                test.execute(Tick{299});
+                test.execute(ExpectNoSegment{});
+                test.execute(Tick{1});
+                test.execute(ExpectSegment{}.with_syn(true).with_seqno(isn));
+            }
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+
+            TCPSenderTestHarness test{"Without adaptive_rto, the RTO ignores the measured RTT", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(Tick{1});
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            test.execute(WriteBytes{"a"});
+            test.execute(ExpectSegment{}.with_data("a"));
+            test.execute(Tick{retx_timeout - 1u});
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{1});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,143 @@
+#include "sender_harness.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <optional>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.sack = true;
+
+            TCPSenderTestHarness test{"Duplicate ACKs in fast recovery resend the holes that SACK reveals", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d", "e", "f", "g"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // "b" and "d" were lost
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 3, isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 6).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 7).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 8).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            // the partial ACK for "b" doesn't resend "d" a second time
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_sack(isn + 5, isn + 8));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 8}});
+            test.execute(ExpectNoSegment{});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            uint16_t retx_timeout = uniform_int_distribution<uint16_t>{10, 10000}(rd);
+            cfg.fixed_isn = isn;
+            cfg.rt_timeout = retx_timeout;
+            cfg.fast_retransmit = true;
+            cfg.sack = true;
+
+            TCPSenderTestHarness test{"Duplicate ACKs after a timeout resend the holes that SACK reveals", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // "a" and "c" were lost, and the ACKs for the others are slow
+            test.execute(Tick{retx_timeout});
+            test.execute(ExpectSegment{}.with_data("a").with_seqno(isn + 1));
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 2, isn + 3));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 1}}.with_sack(isn + 4, isn + 5).with_sack(isn + 2, isn + 3));
+            test.execute(ExpectSegment{}.with_data("c").with_seqno(isn + 3));
+            test.execute(AckReceived{WrappingInt32{isn + 3}}.with_sack(isn + 4, isn + 5));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 5}});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+            cfg.sack = true;
+
+            TCPSenderTestHarness test{"Holes whose retransmissions were lost are resent again after a timeout", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d", "e", "f", "g"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            // "b" and "d" were lost, and so were their retransmissions
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 3, isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 6).with_sack(isn + 3, isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 7).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 8).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(Tick{cfg.rt_timeout});
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(ExpectNoSegment{});
+            // the partial ACK for "b" resends "d", rather than leaving it to another (backed-off) timeout
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_sack(isn + 5, isn + 8));
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 8}});
+            test.execute(ExpectBytesInFlight{0});
+        }
+
+        {
+            TCPConfig cfg;
+            WrappingInt32 isn(rd());
+            cfg.fixed_isn = isn;
+            cfg.fast_retransmit = true;
+
+            TCPSenderTestHarness test{"SACK blocks are ignored unless SACK was offered", cfg};
+            test.execute(ExpectSegment{}.with_no_flags().with_syn(true).with_payload_size(0).with_seqno(isn));
+            test.execute(AckReceived{WrappingInt32{isn + 1}});
+            for (const char *data : {"a", "b", "c", "d", "e", "f", "g"}) {
+                test.execute(WriteBytes{string(data)});
+                test.execute(ExpectSegment{}.with_data(data));
+            }
+            test.execute(AckReceived{WrappingInt32{isn + 2}});
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 3, isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 6).with_sack(isn + 3, isn + 4));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 7).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectSegment{}.with_data("b").with_seqno(isn + 2));
+            test.execute(AckReceived{WrappingInt32{isn + 2}}.with_sack(isn + 5, isn + 8).with_sack(isn + 3, isn + 4));
+            test.execute(ExpectNoSegment{});
+            test.execute(AckReceived{WrappingInt32{isn + 4}}.with_sack(isn + 5, isn + 8));
+            test.execute(ExpectSegment{}.with_data("d").with_seqno(isn + 4));
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return 1;
+    }
+
+    return EXIT_SUCCESS;
+}
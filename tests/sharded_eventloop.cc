@@ -0,0 +1,138 @@
+#include "mpsc_queue.hh"
+#include "sharded_eventloop.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <atomic>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <sys/resource.h>
+#include <thread>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+int main() {
+    try {
+        // every element pushed by every producer comes out once, and each producer's elements stay in order
+        {
+            constexpr unsigned int PRODUCERS = 4, PER_PRODUCER = 100000;
+            MPSCQueue<pair<unsigned int, unsigned int>> queue;
+            vector<thread> producers;
+            for (unsigned int p = 0; p < PRODUCERS; p++) {
+                producers.emplace_back([&queue, p] {
+                    for (unsigned int i = 0; i < PER_PRODUCER; i++) {
+                        queue.push({p, i});
+                    }
+                });
+            }
+
+            vector<unsigned int> next(PRODUCERS, 0);
+            for (unsigned int received = 0; received < PRODUCERS * PER_PRODUCER;) {
+                if (const auto element = queue.pop()) {
+                    const auto [p, i] = *element;
+                    if (i != next.at(p)) {
+                        throw runtime_error("MPSCQueue delivered a producer's elements out of order");
+                    }
+                    next[p]++;
+                    received++;
+                }
+            }
+            for (auto &producer : producers) {
+                producer.join();
+            }
+            test_should_be(queue.pop().has_value(), false);
+        }
+
+        // tasks run on their shard's thread, in the order they were posted
+        {
+            constexpr size_t SHARDS = 4, TASKS = 10000;
+            vector<thread::id> shard_thread(SHARDS);
+            vector<size_t> ran(SHARDS, 0);
+            atomic<bool> wrong_thread{false}, out_of_order{false};
+            {
+                ShardedEventLoop runtime{SHARDS, false};
+                test_should_be(runtime.size(), SHARDS);
+                for (size_t shard = 0; shard < SHARDS; shard++) {
+                    runtime.post(shard, [&, shard](EventLoop &) { shard_thread[shard] = this_thread::get_id(); });
+                }
+                for (size_t i = 0; i < TASKS; i++) {
+                    const size_t shard = i % SHARDS;
+                    runtime.post(shard, [&, shard, i](EventLoop &) {
+                        wrong_thread = wrong_thread or this_thread::get_id() != shard_thread[shard];
+                        out_of_order = out_of_order or ran[shard] != i / SHARDS;
+                        ran[shard]++;
+                    });
+                }
+            }
+            test_should_be(bool(wrong_thread), false);
+            test_should_be(bool(out_of_order), false);
+            for (const size_t count : ran) {
+                test_should_be(count, TASKS / SHARDS);
+            }
+        }
+
+        // both ends of a connection hash the same way
+        {
+            const Address client{"10.0.0.1", 40000}, server{"10.0.0.2", 80};
+            test_should_be(ShardedEventLoop::flow_hash(client, server), ShardedEventLoop::flow_hash(server, client));
+            test_should_be(
+                ShardedEventLoop::flow_hash(client, server) != ShardedEventLoop::flow_hash({"10.0.0.1", 40001}, server),
+                true);
+        }
+
+        // a connection handed to a shard is served there
+        {
+            ShardedEventLoop runtime{2, false};
+            TCPSocket listener;
+            listener.set_reuseaddr();
+            listener.bind({"127.0.0.1", 0});
+            listener.listen();
+
+            TCPSocket client;
+            client.connect(listener.local_address());
+            const size_t shard = runtime.assign(listener.accept(), [](EventLoop &loop, shared_ptr<TCPSocket> socket) {
+                loop.add_rule(*socket, Direction::In, [socket] { socket->write(socket->read()); });
+            });
+            test_should_be(shard, runtime.shard_for(client.peer_address(), client.local_address()));
+
+            client.write("ping");
+            string echoed;
+            while (echoed.size() < 4) {
+                echoed += client.read();
+            }
+            test_should_be(echoed == "ping", true);
+        }
+
+        // a shard that can't be made stops the ones already running, rather than leaving their threads behind
+        {
+            const int lowest_free_fd = SystemCall("dup", ::dup(STDIN_FILENO));
+            SystemCall("close", ::close(lowest_free_fd));
+            rlimit limit{};
+            SystemCall("getrlimit", ::getrlimit(RLIMIT_NOFILE, &limit));
+            const rlimit original = limit;
+            limit.rlim_cur = lowest_free_fd + 3;  // room for the first shard's fds, but not the second's
+            SystemCall("setrlimit", ::setrlimit(RLIMIT_NOFILE, &limit));
+            bool threw = false;
+            try {
+                ShardedEventLoop runtime{4, false};
+            } catch (const unix_error &) {
+                threw = true;
+            }
+            SystemCall("setrlimit", ::setrlimit(RLIMIT_NOFILE, &original));
+            test_should_be(threw, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
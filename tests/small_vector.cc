@@ -0,0 +1,84 @@
+#include "buffer.hh"
+#include "small_vector.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdlib>
+#include <deque>
+#include <exception>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+using namespace std;
+
+//! Check that `actual` holds the same elements as `expected`
+static void check(const SmallVector<string, 4> &actual, const deque<string> &expected) {
+    test_should_be(actual.size(), expected.size());
+    test_should_be(actual.empty(), expected.empty());
+    if (not equal(actual.begin(), actual.end(), expected.begin(), expected.end())) {
+        throw runtime_error("SmallVector holds the wrong elements");
+    }
+}
+
+int main() {
+    try {
+        // a mix of pushes and pops behaves like a deque, inline or spilled
+        {
+            auto rd = get_random_generator();
+            SmallVector<string, 4> small;
+            deque<string> reference;
+            for (unsigned int i = 0; i < 10000; i++) {
+                if (reference.empty() or rd() % 3 != 0) {
+                    small.push_back(to_string(i));
+                    reference.push_back(to_string(i));
+                } else {
+                    test_should_be(small.front() == reference.front(), true);
+                    small.pop_front();
+                    reference.pop_front();
+                }
+                if (i % 2000 == 1999) {
+                    small.clear();
+                    reference.clear();
+                }
+                check(small, reference);
+                if (not reference.empty()) {
+                    test_should_be(small.back() == reference.back(), true);
+                }
+            }
+        }
+
+        // copies are independent
+        {
+            SmallVector<string, 4> a;
+            for (const char *s : {"a", "b", "c"}) {
+                a.push_back(s);
+            }
+            SmallVector<string, 4> b = a;
+            a.pop_front();
+            b.push_back("d");
+            b.push_back("e");
+            check(a, {"b", "c"});
+            check(b, {"a", "b", "c", "d", "e"});
+        }
+
+        // a header-plus-payload BufferList, and its views, stay inline
+        {
+            BufferList packet{string("header")};
+            packet.append(BufferList{string("payload")});
+            BufferViewList views{packet};
+            test_should_be(views.as_iovecs().size(), size_t{2});
+            views.remove_prefix(8);
+            test_should_be(views.size(), size_t{5});
+            test_should_be(views.as_iovecs().size(), size_t{1});
+            test_should_be(string(static_cast<const char *>(views.as_iovecs().front().iov_base), 5) == "yload",
+                           true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
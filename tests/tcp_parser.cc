@@ -189,7 +189,7 @@ int main(int argc, char **argv) {
             cout << dec;
 
             TCPSegment tcp_seg_copy;
-            tcp_seg_copy.payload() = tcp_seg.payload();
+            tcp_seg_copy.set_payload(tcp_seg.payload());
 
             // set headers in new segment, and fix up to remove extensions
             {
@@ -0,0 +1,89 @@
+#include "tcp_segment.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+#include "wrapping_integers.hh"
+
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Serialize `seg` into caller-provided storage (with some room to spare), and check that it gives the same
+//! bytes as serialize(), writing nothing past them
+static void check_serialize_into(const TCPSegment &seg, const uint32_t pseudo_sum) {
+    vector<uint8_t> storage(seg.serialized_size() + 3, 0xaa);
+    test_should_be(seg.serialize_into(storage.data(), storage.size(), pseudo_sum), seg.serialized_size());
+    const string raw = seg.serialize(pseudo_sum).concatenate();
+    test_should_be(raw.size(), seg.serialized_size());
+    test_should_be(string(storage.begin(), storage.begin() + raw.size()) == raw, true);
+    test_should_be(storage.back(), uint8_t{0xaa});
+
+    TCPSegment parsed;
+    test_should_be(parsed.parse(string(raw), pseudo_sum) == ParseResult::NoError, true);
+    test_should_be(parsed.header() == seg.header(), true);
+    test_should_be(parsed.payload().copy() == seg.payload().copy(), true);
+}
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // a bare segment, with and without a payload
+        {
+            TCPSegment seg;
+            seg.header().seqno = WrappingInt32(static_cast<uint32_t>(rd()));
+            seg.header().ack = true;
+            seg.header().ackno = WrappingInt32(static_cast<uint32_t>(rd()));
+            seg.header().win = static_cast<uint16_t>(rd());
+            check_serialize_into(seg, 0);
+            seg.set_payload(string(1000, 'x'));
+            check_serialize_into(seg, uniform_int_distribution<uint32_t>{0, 0x3'ffff}(rd));
+        }
+
+        // a segment with every option, whose padding is written too
+        {
+            TCPSegment seg;
+            TCPHeader &header = seg.header();
+            header.syn = true;
+            header.seqno = WrappingInt32(static_cast<uint32_t>(rd()));
+            header.mss = 1460;
+            header.window_scale = 7;
+            header.sack_permitted = true;
+            header.timestamps = TCPTimestamps{static_cast<uint32_t>(rd()), static_cast<uint32_t>(rd())};
+            header.sack_blocks.push_back({WrappingInt32{10}, WrappingInt32{15}});
+            header.doff = (TCPHeader::LENGTH + header.options_length()) / 4;
+            seg.set_payload(string("hello"));
+            check_serialize_into(seg, 0x1234);
+        }
+
+        // storage too small for the whole segment is refused
+        {
+            TCPSegment seg;
+            seg.set_payload(string("hello"));
+            vector<uint8_t> storage(seg.serialized_size() - 1);
+            try {
+                seg.serialize_into(storage.data(), storage.size());
+                throw runtime_error("serialize_into() should need room for the whole segment");
+            } catch (const runtime_error &e) {
+                test_should_be(string(e.what()) == "no room to serialize TCP segment", true);
+            }
+            try {
+                seg.header().serialize_into(storage.data(), 4 * seg.header().doff - 1);
+                throw runtime_error("serialize_into() should need room for the whole header");
+            } catch (const runtime_error &e) {
+                test_should_be(string(e.what()) == "no room to serialize TCP header", true);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
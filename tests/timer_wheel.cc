@@ -0,0 +1,153 @@
+#include "eventloop.hh"
+#include "tcp_sender.hh"
+#include "test_should_be.hh"
+#include "timer_wheel.hh"
+#include "util.hh"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <functional>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <random>
+#include <stdexcept>
+
+using namespace std;
+
+int main() {
+    try {
+        auto rd = get_random_generator();
+
+        // timers fire exactly when they expire, however far off that is and however the wheel is advanced
+        {
+            TimerWheel wheel;
+            map<TimerWheel::TimerId, uint64_t> expected;  // expiry of each timer that should still fire
+            size_t fired = 0;
+
+            // arm a timer that checks that it fires on time, and sometimes arms another when it does
+            function<void(uint64_t)> arm = [&](const uint64_t delay) {
+                const uint64_t expiry = wheel.now() + max(delay, uint64_t{1});
+                const auto id = make_shared<TimerWheel::TimerId>();
+                *id = wheel.add(delay, [&, expiry, id] {
+                    if (wheel.now() != expiry or expected.erase(*id) != 1) {
+                        throw runtime_error("timer fired at the wrong time");
+                    }
+                    fired++;
+                    if (rd() % 4 == 0) {
+                        arm(rd() % 1000);
+                    }
+                });
+                expected[*id] = expiry;
+            };
+
+            for (unsigned int round = 0; round < 200; round++) {
+                for (unsigned int i = 0; i < 100; i++) {
+                    const unsigned int bits = rd() % 30;
+                    arm(rd() % (uint64_t{1} << bits));
+                }
+                for (unsigned int i = 0; i < 20 and not expected.empty(); i++) {
+                    auto victim = expected.begin();
+                    advance(victim, rd() % expected.size());
+                    test_should_be(wheel.cancel(victim->first), true);
+                    test_should_be(wheel.cancel(victim->first), false);
+                    expected.erase(victim);
+                }
+                test_should_be(wheel.size(), expected.size());
+                wheel.advance(wheel.now() + rd() % (uint64_t{1} << (rd() % 20)));
+            }
+
+            // run out the clock: everything still armed fires, at its time
+            uint64_t last = 0;
+            for (const auto &[id, expiry] : expected) {
+                last = max(last, expiry);
+            }
+            while (not expected.empty()) {
+                wheel.advance(max(last, wheel.now() + 1));
+                last = 0;
+                for (const auto &[id, expiry] : expected) {
+                    last = max(last, expiry);
+                }
+            }
+            test_should_be(wheel.empty(), true);
+            test_should_be(wheel.next_expiry().has_value(), false);
+            test_should_be(fired > 0, true);
+        }
+
+        // a timer further off than the outermost wheel reaches waits there until it is in reach
+        {
+            TimerWheel wheel;
+            const uint64_t expiry = (uint64_t{1} << 33) + 12345;
+            bool fired = false;
+            wheel.add(expiry, [&] { fired = wheel.now() == expiry; });
+            wheel.advance(expiry - 1);
+            test_should_be(fired, false);
+            wheel.advance(expiry);
+            test_should_be(fired, true);
+        }
+
+        // next_expiry() is exact within the first wheel's turn, and never late
+        {
+            TimerWheel wheel;
+            wheel.advance(1000);
+            wheel.add(10, [] {});
+            test_should_be(wheel.next_expiry().value(), uint64_t{10});
+            wheel.advance(1010);
+            wheel.add(100000, [] {});
+            const uint64_t next = wheel.next_expiry().value();
+            test_should_be(next >= 1 and next <= 256, true);
+        }
+
+        // a retransmission timer keeps a timer on the wheel armed while it runs
+        {
+            TimerWheel wheel;
+            TCPTimer timer{1000};
+            unsigned int expired = 0;
+            timer.set_wheel(wheel, [&] { expired++; });
+            test_should_be(wheel.size(), size_t{0});
+
+            timer.start(1000);
+            wheel.advance(600);
+            timer.add(600);
+            timer.restart();
+            wheel.advance(1599);
+            test_should_be(expired, 0u);
+            wheel.advance(1600);
+            test_should_be(expired, 1u);
+
+            timer.start(1000);
+            timer.double_rto();
+            wheel.advance(3599);
+            test_should_be(expired, 1u);
+            timer.stop();
+            test_should_be(wheel.size(), size_t{0});
+
+            timer.start(50);
+            {
+                TCPTimer moved{move(timer)};
+                test_should_be(wheel.size(), size_t{1});
+            }
+            test_should_be(wheel.size(), size_t{0});
+        }
+
+        // an EventLoop fires its timers, and keeps going while any are armed
+        {
+            EventLoop loop;
+            unsigned int fired = 0;
+            loop.add_timer(5, [&] { fired++; });
+            const auto canceled = loop.add_timer(1, [&] { fired += 100; });
+            test_should_be(loop.cancel_timer(canceled), true);
+            while (loop.wait_next_event(-1) != EventLoop::Result::Exit) {
+            }
+            test_should_be(fired, 1u);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,170 @@
+#include "sharded_eventloop.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "tun.hh"
+#include "util.hh"
+
+#include <arpa/inet.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <linux/if.h>
+#include <memory>
+#include <netinet/in.h>
+#include <optional>
+#include <sched.h>
+#include <stdexcept>
+#include <string>
+#include <sys/ioctl.h>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+static constexpr const char *DEVNAME = "mq0";
+static constexpr size_t QUEUES = 4;
+
+//! Number of UDP flows sent out through the device
+static constexpr uint16_t FLOWS = 64;
+
+//! The device's address; the rest of its /24 is routed out through it
+static constexpr const char *LOCAL_ADDRESS = "10.144.0.1";
+static constexpr const char *PEER_ADDRESS = "10.144.0.2";
+
+//! Give the device its address and bring it up
+static void configure(const string &devname) {
+    FileDescriptor sock{SystemCall("socket", ::socket(AF_INET, SOCK_DGRAM, 0))};
+    struct ifreq req {};
+    strncpy(static_cast<char *>(req.ifr_name), devname.c_str(), IFNAMSIZ - 1);
+
+    const auto set_address = [&](const unsigned long request, const char *address) {
+        sockaddr_in sin{};
+        sin.sin_family = AF_INET;
+        inet_pton(AF_INET, address, &sin.sin_addr);
+        memcpy(&req.ifr_addr, &sin, sizeof(sin));
+        SystemCall("ioctl", ioctl(sock.fd_num(), request, &req));
+    };
+    set_address(SIOCSIFADDR, LOCAL_ADDRESS);
+    set_address(SIOCSIFNETMASK, "255.255.255.0");
+
+    SystemCall("ioctl", ioctl(sock.fd_num(), SIOCGIFFLAGS, &req));
+    req.ifr_flags |= IFF_UP;
+    SystemCall("ioctl", ioctl(sock.fd_num(), SIOCSIFFLAGS, &req));
+}
+
+//! The flow of an IPv4 UDP datagram sent to PEER_ADDRESS (the number of its destination port, less 1024)
+static optional<uint16_t> flow_of(const string_view packet) {
+    if (packet.size() < 28 or (packet[0] >> 4) != 4 or packet[9] != IPPROTO_UDP) {
+        return {};  // e.g. IPv6 router solicitations, which the kernel sends on its own
+    }
+    uint32_t destination{};
+    memcpy(&destination, packet.data() + 16, sizeof(destination));
+    if (destination != inet_addr(PEER_ADDRESS)) {
+        return {};
+    }
+    const size_t header_length = (packet[0] & 0xf) * 4;
+    const uint16_t port = (uint8_t(packet[header_length + 2]) << 8) | uint8_t(packet[header_length + 3]);
+    return port - 1024;
+}
+
+//! One UDP socket per flow, each sending to its own port of PEER_ADDRESS
+static vector<UDPSocket> send_flows(const size_t per_flow) {
+    vector<UDPSocket> senders(FLOWS);
+    for (uint16_t flow = 0; flow < FLOWS; flow++) {
+        senders[flow].connect({PEER_ADDRESS, uint16_t(1024 + flow)});
+        for (size_t i = 0; i < per_flow; i++) {
+            senders[flow].write("flow " + to_string(flow));
+        }
+    }
+    return senders;
+}
+
+int main() {
+    try {
+        // a device of our own, in a network namespace of our own (which needs CAP_SYS_ADMIN and CAP_NET_ADMIN)
+        vector<TunFD> queues;
+        try {
+            SystemCall("unshare", ::unshare(CLONE_NEWNET));
+            queues = TunFD::open_queues(DEVNAME, QUEUES);
+            configure(DEVNAME);
+        } catch (const exception &e) {
+            cerr << "can't create a multi-queue TUN device (" << e.what() << "); skipping\n";
+            return EXIT_SUCCESS;
+        }
+        test_should_be(queues.size(), QUEUES);
+        for (auto &queue : queues) {
+            queue.set_blocking(false);
+        }
+
+        // the packets of each flow go to one queue, and the flows are spread across the queues
+        {
+            const auto senders = send_flows(2);
+            vector<Buffer> packets;
+            vector<size_t> queue_of_flow(FLOWS, QUEUES), packets_of_flow(FLOWS, 0);
+            size_t queues_used = 0;
+            for (size_t q = 0; q < QUEUES; q++) {
+                // (a few at a time, as a callback that doesn't want to hog its EventLoop would)
+                packets.clear();
+                while (queues[q].read_packets(packets, 4) == 4) {
+                }
+                bool used = false;
+                for (const auto &packet : packets) {
+                    if (const auto flow = flow_of(packet.str())) {
+                        test_should_be(queue_of_flow.at(*flow) == QUEUES or queue_of_flow[*flow] == q, true);
+                        queue_of_flow[*flow] = q;
+                        packets_of_flow[*flow]++;
+                        used = true;
+                    }
+                }
+                queues_used += used;
+            }
+            for (const size_t count : packets_of_flow) {
+                test_should_be(count, size_t{2});
+            }
+            test_should_be(queues_used > 1, true);
+
+            // an empty queue returns nothing, instead of waiting, and that doesn't count as a read
+            packets.clear();
+            const unsigned read_count = queues[0].read_count();
+            test_should_be(queues[0].read_packets(packets), size_t{0});
+            test_should_be(queues[0].read_count(), read_count);
+            test_should_be(queues[0].eof(), false);
+        }
+
+        // one shard per queue, each reading its queue's packets in batches
+        {
+            atomic<size_t> received{0};
+            {
+                ShardedEventLoop runtime{QUEUES, false};
+                for (size_t q = 0; q < QUEUES; q++) {
+                    auto queue = make_shared<TunFD>(move(queues[q]));
+                    runtime.post(q, [queue, &received](EventLoop &loop) {
+                        loop.add_rule(*queue, Direction::In, [queue, &received] {
+                            vector<Buffer> packets;
+                            queue->read_packets(packets);
+                            for (const auto &packet : packets) {
+                                received += flow_of(packet.str()).has_value();
+                            }
+                        });
+                    });
+                }
+
+                constexpr size_t PER_FLOW = 10;
+                const auto senders = send_flows(PER_FLOW);
+                const auto deadline = chrono::steady_clock::now() + chrono::seconds(5);
+                while (received < FLOWS * PER_FLOW and chrono::steady_clock::now() < deadline) {
+                    this_thread::sleep_for(chrono::milliseconds(1));
+                }
+                test_should_be(received.load(), FLOWS * PER_FLOW);
+            }
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "address.hh"
+#include "buffer.hh"
+#include "socket.hh"
+#include "test_should_be.hh"
+#include "util.hh"
+
+#include <cstdlib>
+#include <exception>
+#include <iostream>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+//! Receive `count` datagrams (or fewer, if that many never arrive) from a non-blocking socket
+static vector<string> receive(UDPSocket &sock, const size_t count) {
+    vector<string> received;
+    UDPSocket::received_batch batch{8};
+    for (size_t attempt = 0; attempt < 100 and received.size() < count; attempt++) {
+        try {
+            sock.recv_batch(batch);
+        } catch (const unix_error &) {  // EAGAIN: nothing there yet
+            continue;
+        }
+        for (size_t i = 0; i < batch.size(); i++) {
+            received.emplace_back(batch.payload(i));
+        }
+    }
+    return received;
+}
+
+int main() {
+    try {
+        UDPSocket receiver;
+        receiver.set_gro();
+        receiver.bind(Address("127.0.0.1", 0));
+        receiver.set_blocking(false);
+        UDPSocket sender;
+        sender.connect(receiver.local_address());
+
+        // trains of equal-sized datagrams, ending with a shorter one, arrive as the datagrams they were made of
+        {
+            const vector<string> payloads{string(1000, 'a'), string(1000, 'b'), string(1000, 'c'), "d", "e"};
+            test_should_be(sender.send_trains({payloads.begin(), payloads.end()}), payloads.size());
+            const auto received = receive(receiver, payloads.size());
+            test_should_be(received.size(), payloads.size());
+            test_should_be(received == payloads, true);
+        }
+
+        // empty datagrams each go by themselves, rather than as one train that the kernel sends as one datagram
+        {
+            const vector<string> payloads{"", "", "", "", "f", ""};
+            test_should_be(sender.send_trains({payloads.begin(), payloads.end()}), payloads.size());
+            const auto received = receive(receiver, payloads.size());
+            test_should_be(received.size(), payloads.size());
+            test_should_be(received == payloads, true);
+        }
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        return EXIT_FAILURE;
+    }
+
+    return EXIT_SUCCESS;
+}